@@ -0,0 +1,78 @@
+// Throughput of parse_fields over a buffer of comma-separated int64 fields:
+// the AVX2 path against the scalar memchr + parse<std::int64_t> path, for
+// short and long fields and a few invalid ones. Reports ns per buffer and
+// GB/s.
+//
+//   make bench_batch_parse && ./out/bench_batch_parse --json batch_parse.json
+#include <cstdio>
+#include <random>
+#include <string>
+#include "batch_parse.hpp"
+#include "bench/bench.hpp"
+
+constexpr std::size_t buffer_bytes = 256 * 1024;
+
+static auto make_buffer(int max_digits, int error_percent) -> std::string {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> digits(1, max_digits);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::string buf;
+    while (buf.size() < buffer_bytes) {
+        auto begin = buf.size();
+        if (rng() % 4 == 0) {
+            buf += '-';
+        }
+        auto n = digits(rng);
+        for (int d = 0; d < n; ++d) {
+            buf += static_cast<char>('0' + rng() % 10);
+        }
+        if (percent(rng) < error_percent) {
+            buf[begin + (buf.size() - begin) / 2] = 'x';
+        }
+        buf += ',';
+    }
+    return buf;
+}
+
+template<typename F>
+static auto bench_buffer(bench::Report& report, const char* name, const std::string& buf, int max_digits, int rate, F parse_all) -> void {
+    ResultVector<std::int64_t, ParseError> out;
+    out.reserve(buf.size() / 2);
+    auto m = bench::measure([&] (std::uint64_t) {
+        out.clear();
+        parse_all(buf, out);
+        bench::do_not_optimize(out.size());
+    }, 100.0);
+    char gbps[32];
+    std::snprintf(gbps, sizeof(gbps), "%.2f", static_cast<double>(buf.size()) / m.ns_per_op);
+    report.add(name, {
+        { "max_digits", std::to_string(max_digits) },
+        { "error_rate", std::to_string(rate) },
+        { "fields", std::to_string(out.size()) },
+        { "gb_per_s", gbps },
+    }, m);
+}
+
+int main(int argc, char** argv) {
+    bench::Report report;
+    for (int max_digits : { 4, 8, 16, 19 }) {
+        for (int rate : { 0, 5 }) {
+            auto buf = make_buffer(max_digits, rate);
+            bench_buffer(report, "scalar", buf, max_digits, rate, [] (std::string_view b, auto& out) {
+                detail::parse_fields_scalar(b, ',', out);
+            });
+            bench_buffer(report, "parse_fields", buf, max_digits, rate, [] (std::string_view b, auto& out) {
+                parse_fields(b, ',', out);
+            });
+        }
+    }
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
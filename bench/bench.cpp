@@ -0,0 +1,246 @@
+// Result<T, E> against exceptions, errno-style codes, std::expected and
+// out-parameters. Sweeps error rate, payload size and call depth.
+//
+//   make bench && ./out/bench --json bench.json
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench/bench.hpp"
+#include "result.hpp"
+
+#if __has_include(<expected>)
+#include <expected>
+#endif
+
+enum class BenchError {
+    Failed,
+};
+
+template<>
+struct Display<BenchError> {
+    static void print(BenchError) {}
+};
+
+template<std::size_t N>
+struct Payload {
+    std::uint64_t words[N / sizeof(std::uint64_t)];
+};
+
+struct BenchException {
+    BenchError error;
+};
+
+// Leaf failures follow a shuffled pattern with the requested error rate
+constexpr std::size_t pattern_size = 4096;
+static std::uint8_t fail_pattern[pattern_size];
+
+static auto set_error_rate(int percent) -> void {
+    for (std::size_t i = 0; i < pattern_size; ++i) {
+        fail_pattern[i] = i * 100 < pattern_size * static_cast<std::size_t>(percent);
+    }
+    std::shuffle(fail_pattern, fail_pattern + pattern_size, std::mt19937(42));
+}
+
+static inline auto should_fail(std::uint64_t i) -> bool {
+    return fail_pattern[i & (pattern_size - 1)];
+}
+
+template<typename P>
+static inline auto make_payload(std::uint64_t i) -> P {
+    P p {};
+    p.words[0] = i;
+    return p;
+}
+
+struct ResultStrategy {
+    static constexpr const char* name = "result";
+
+    template<int Depth, typename P>
+    [[gnu::noinline]] static auto call(std::uint64_t i) -> Result<P, BenchError> {
+        if constexpr (Depth == 1) {
+            if (should_fail(i)) {
+                return err<P, BenchError>(BenchError::Failed);
+            }
+            return ok<P, BenchError>(make_payload<P>(i));
+        } else {
+            auto r = call<Depth - 1, P>(i);
+            if (r.tag == Result<P, BenchError>::Tag::Err) {
+                return err<P, BenchError>(r.error);
+            }
+            r.value.words[0] += 1;
+            return r;
+        }
+    }
+
+    template<int Depth, typename P>
+    static auto run(std::uint64_t i) -> std::uint64_t {
+        auto r = call<Depth, P>(i);
+        return r.tag == Result<P, BenchError>::Tag::Ok ? r.value.words[0] : 1;
+    }
+};
+
+struct ExceptionStrategy {
+    static constexpr const char* name = "exception";
+
+    template<int Depth, typename P>
+    [[gnu::noinline]] static auto call(std::uint64_t i) -> P {
+        if constexpr (Depth == 1) {
+            if (should_fail(i)) {
+                throw BenchException { BenchError::Failed };
+            }
+            return make_payload<P>(i);
+        } else {
+            auto p = call<Depth - 1, P>(i);
+            p.words[0] += 1;
+            return p;
+        }
+    }
+
+    template<int Depth, typename P>
+    static auto run(std::uint64_t i) -> std::uint64_t {
+        try {
+            return call<Depth, P>(i).words[0];
+        } catch (const BenchException&) {
+            return 1;
+        }
+    }
+};
+
+// errno-style: the return value is only meaningful when the error slot is clear
+static thread_local int bench_errno = 0;
+
+struct ErrnoStrategy {
+    static constexpr const char* name = "errno";
+
+    template<int Depth, typename P>
+    [[gnu::noinline]] static auto call(std::uint64_t i) -> P {
+        if constexpr (Depth == 1) {
+            if (should_fail(i)) {
+                bench_errno = 1;
+                return P {};
+            }
+            return make_payload<P>(i);
+        } else {
+            auto p = call<Depth - 1, P>(i);
+            if (bench_errno != 0) {
+                return p;
+            }
+            p.words[0] += 1;
+            return p;
+        }
+    }
+
+    template<int Depth, typename P>
+    static auto run(std::uint64_t i) -> std::uint64_t {
+        bench_errno = 0;
+        auto p = call<Depth, P>(i);
+        return bench_errno == 0 ? p.words[0] : 1;
+    }
+};
+
+struct OutParamStrategy {
+    static constexpr const char* name = "out_param";
+
+    template<int Depth, typename P>
+    [[gnu::noinline]] static auto call(std::uint64_t i, P& out) -> int {
+        if constexpr (Depth == 1) {
+            if (should_fail(i)) {
+                return 1;
+            }
+            out = make_payload<P>(i);
+            return 0;
+        } else {
+            if (auto rc = call<Depth - 1, P>(i, out); rc != 0) {
+                return rc;
+            }
+            out.words[0] += 1;
+            return 0;
+        }
+    }
+
+    template<int Depth, typename P>
+    static auto run(std::uint64_t i) -> std::uint64_t {
+        P p;
+        return call<Depth, P>(i, p) == 0 ? p.words[0] : 1;
+    }
+};
+
+#ifdef __cpp_lib_expected
+struct ExpectedStrategy {
+    static constexpr const char* name = "std_expected";
+
+    template<int Depth, typename P>
+    [[gnu::noinline]] static auto call(std::uint64_t i) -> std::expected<P, BenchError> {
+        if constexpr (Depth == 1) {
+            if (should_fail(i)) {
+                return std::unexpected(BenchError::Failed);
+            }
+            return make_payload<P>(i);
+        } else {
+            auto r = call<Depth - 1, P>(i);
+            if (!r) {
+                return std::unexpected(r.error());
+            }
+            r->words[0] += 1;
+            return r;
+        }
+    }
+
+    template<int Depth, typename P>
+    static auto run(std::uint64_t i) -> std::uint64_t {
+        auto r = call<Depth, P>(i);
+        return r ? r->words[0] : 1;
+    }
+};
+#endif
+
+template<typename Strategy, int Depth, typename P>
+static auto bench_one(bench::Report& report, int rate, std::size_t payload) -> void {
+    auto m = bench::measure([] (std::uint64_t i) {
+        bench::do_not_optimize(Strategy::template run<Depth, P>(i));
+    });
+    report.add(Strategy::name, {
+        { "error_rate", std::to_string(rate) },
+        { "payload", std::to_string(payload) },
+        { "depth", std::to_string(Depth) },
+    }, m);
+}
+
+template<typename Strategy, int Depth>
+static auto bench_payloads(bench::Report& report, int rate) -> void {
+    bench_one<Strategy, Depth, Payload<8>>(report, rate, 8);
+    bench_one<Strategy, Depth, Payload<64>>(report, rate, 64);
+    bench_one<Strategy, Depth, Payload<256>>(report, rate, 256);
+}
+
+template<typename Strategy>
+static auto bench_strategy(bench::Report& report, int rate) -> void {
+    bench_payloads<Strategy, 1>(report, rate);
+    bench_payloads<Strategy, 4>(report, rate);
+    bench_payloads<Strategy, 16>(report, rate);
+}
+
+int main(int argc, char** argv) {
+    bench::Report report;
+    for (int rate : { 0, 1, 10, 50, 100 }) {
+        set_error_rate(rate);
+        bench_strategy<ResultStrategy>(report, rate);
+        bench_strategy<ExceptionStrategy>(report, rate);
+        bench_strategy<ErrnoStrategy>(report, rate);
+        bench_strategy<OutParamStrategy>(report, rate);
+#ifdef __cpp_lib_expected
+        bench_strategy<ExpectedStrategy>(report, rate);
+#endif
+    }
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bench/perf_counters.hpp"
+
+// Minimal benchmark harness shared by the programs in bench/.
+namespace bench {
+
+template<typename T>
+inline auto do_not_optimize(T const& value) -> void {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Measurement {
+    double ns_per_op;
+    std::uint64_t ops;
+    Counters counters; // totals over `ops`, empty in time-only mode
+
+    auto per_op(Counter c) const -> double {
+        return static_cast<double>(counters[c]) / static_cast<double>(ops);
+    }
+};
+
+// Counter group shared by all measurements, opened on first use. Falls back
+// to time-only mode when the counters are unavailable.
+inline auto perf_group() -> const PerfGroup* {
+    static auto group = [] {
+        auto g = open_perf_group();
+        if (g.tag == Result<PerfGroup, PerfError>::Tag::Err) {
+            Display<PerfError>::print(g.error);
+            std::fputs("perf: reporting time only\n", stderr);
+        }
+        return g;
+    }();
+
+    return group.tag == Result<PerfGroup, PerfError>::Tag::Ok ? &group.value : nullptr;
+}
+
+// Time op(i) for i in [0, n), growing n until a run takes at least min_ms,
+// then report the best of `repeats` runs.
+template<typename F>
+auto measure(F&& op, double min_ms = 10.0, int repeats = 3) -> Measurement {
+    auto group = perf_group();
+    auto run = [&] (std::uint64_t n, Counters& counters) {
+        if (group) {
+            group->start();
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < n; ++i) {
+            op(i);
+        }
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (group) {
+            group->stop();
+            counters = unwrap_or(group->read(), Counters {});
+        }
+        return ns;
+    };
+
+    Counters counters {};
+    std::uint64_t n = 1024;
+    while (run(n, counters) < min_ms * 1e6 && n < (std::uint64_t(1) << 32)) {
+        n *= 2;
+    }
+
+    auto best = run(n, counters);
+    for (int i = 1; i < repeats; ++i) {
+        Counters c {};
+        if (auto ns = run(n, c); ns < best) {
+            best = ns;
+            counters = c;
+        }
+    }
+
+    return Measurement { best / static_cast<double>(n), n, counters };
+}
+
+struct CounterColumn {
+    Counter counter;
+    const char* name;
+};
+
+inline constexpr CounterColumn counter_columns[] = {
+    { Counter::Cycles, "cycles" },
+    { Counter::Instructions, "instructions" },
+    { Counter::BranchMisses, "branch_misses" },
+    { Counter::L1iMisses, "l1i_misses" },
+};
+
+// One benchmark result: a name, its parameters and the measurement
+struct Row {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> params;
+    Measurement m;
+};
+
+class Report {
+public:
+    auto add(std::string name, std::vector<std::pair<std::string, std::string>> params, Measurement m) -> void {
+        std::printf("%-24s", name.c_str());
+        for (auto& [k, v] : params) {
+            std::printf(" %s=%-6s", k.c_str(), v.c_str());
+        }
+        std::printf(" %10.2f ns/op", m.ns_per_op);
+        for (auto& col : counter_columns) {
+            if (m.counters.has(col.counter)) {
+                std::printf(" %8.2f %s", m.per_op(col.counter), col.name);
+            }
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+        rows.push_back({ std::move(name), std::move(params), m });
+    }
+
+    auto write_json(std::FILE* out) const -> void {
+        std::fprintf(out, "[\n");
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            auto& row = rows[i];
+            std::fprintf(out, "  {\"name\": \"%s\"", row.name.c_str());
+            for (auto& [k, v] : row.params) {
+                auto numeric = !v.empty() && v.find_first_not_of("0123456789.-") == std::string::npos;
+                std::fprintf(out, numeric ? ", \"%s\": %s" : ", \"%s\": \"%s\"", k.c_str(), v.c_str());
+            }
+            std::fprintf(out, ", \"ops\": %llu, \"ns_per_op\": %.3f", static_cast<unsigned long long>(row.m.ops), row.m.ns_per_op);
+            for (auto& col : counter_columns) {
+                if (row.m.counters.has(col.counter)) {
+                    std::fprintf(out, ", \"%s\": %.3f", col.name, row.m.per_op(col.counter));
+                } else {
+                    std::fprintf(out, ", \"%s\": null", col.name);
+                }
+            }
+            std::fprintf(out, "}%s\n", i + 1 == rows.size() ? "" : ",");
+        }
+        std::fprintf(out, "]\n");
+    }
+
+private:
+    std::vector<Row> rows;
+};
+
+// Parse `--json <path>` from argv, returns nullptr when absent
+inline auto json_path(int argc, char** argv) -> const char* {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--json") {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+} // namespace bench
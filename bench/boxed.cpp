@@ -0,0 +1,82 @@
+// Result<int, E> with a large inline error against Result<int, Boxed<E>>,
+// propagated through a few calls at realistic error rates.
+//
+//   make bench_boxed && ./out/bench_boxed --json boxed.json
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include "bench/bench.hpp"
+#include "boxed.hpp"
+#include "result.hpp"
+
+struct RichError {
+    int code;
+    int line;
+    const char* file;
+    char message[112];
+};
+
+template<>
+struct Display<RichError> {
+    static void print(const RichError& e) {
+        std::fprintf(stderr, "%s:%d: error %d: %s\n", e.file, e.line, e.code, e.message);
+    }
+};
+
+constexpr std::size_t pattern_size = 4096;
+static std::uint8_t fail_pattern[pattern_size];
+
+static auto set_error_rate(int percent) -> void {
+    for (std::size_t i = 0; i < pattern_size; ++i) {
+        fail_pattern[i] = i * 100 < pattern_size * static_cast<std::size_t>(percent);
+    }
+    std::shuffle(fail_pattern, fail_pattern + pattern_size, std::mt19937(7));
+}
+
+template<typename E>
+[[gnu::noinline]] static auto leaf(std::uint64_t i) -> Result<int, E> {
+    if (fail_pattern[i & (pattern_size - 1)]) {
+        return err<int, E>(RichError { 42, __LINE__, __FILE__, "lookup failed" });
+    }
+    return ok<int, E>(static_cast<int>(i));
+}
+
+template<typename E, int Depth>
+[[gnu::noinline]] static auto call(std::uint64_t i) -> Result<int, E> {
+    if constexpr (Depth == 1) {
+        return leaf<E>(i);
+    } else {
+        return call<E, Depth - 1>(i).map([] (int v) { return v + 1; });
+    }
+}
+
+template<typename E>
+static auto bench_error(bench::Report& report, const char* name, int rate) -> void {
+    auto m = bench::measure([] (std::uint64_t i) {
+        auto r = call<E, 4>(i);
+        bench::do_not_optimize(r.tag);
+    });
+    report.add(name, {
+        { "error_rate", std::to_string(rate) },
+        { "result_size", std::to_string(sizeof(Result<int, E>)) },
+    }, m);
+}
+
+int main(int argc, char** argv) {
+    bench::Report report;
+    for (int rate : { 0, 1, 5, 10, 50 }) {
+        set_error_rate(rate);
+        bench_error<RichError>(report, "inline", rate);
+        bench_error<Boxed<RichError>>(report, "boxed", rate);
+    }
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
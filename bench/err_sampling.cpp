@@ -0,0 +1,47 @@
+// Per-err() overhead of sampled stack capture at several sampling rates.
+// Build with `make bench_sampling`, which enables RESULT_STACK_SAMPLING.
+#include <cstdio>
+#include <string>
+#include "bench/bench.hpp"
+#include "result.hpp"
+
+enum class BenchError {
+    Failed,
+};
+
+template<>
+struct Display<BenchError> {
+    static void print(BenchError) {}
+};
+
+[[gnu::noinline]] static auto leaf(int i) -> Result<int, BenchError> {
+    return err<int, BenchError>(static_cast<BenchError>(i & 0));
+}
+
+[[gnu::noinline]] static auto middle(int i) -> Result<int, BenchError> {
+    return leaf(i).map([] (int v) { return v + 1; });
+}
+
+[[gnu::noinline]] static auto outer(int i) -> Result<int, BenchError> {
+    return middle(i).map([] (int v) { return v * 2; });
+}
+
+static auto run(std::uint32_t rate) -> double {
+    set_stack_sample_rate(rate);
+    return bench::measure([] (std::uint64_t i) {
+        bench::do_not_optimize(outer(static_cast<int>(i)));
+    }).ns_per_op;
+}
+
+int main() {
+    const std::uint32_t rates[] = { 0, 65536, 4096, 256, 16, 1 };
+
+    auto baseline = run(0);
+    std::printf("%-10s %10s %10s\n", "rate", "ns/err", "overhead");
+    for (auto rate : rates) {
+        auto ns = run(rate);
+        std::printf("%-10s %10.2f %10.2f\n", rate == 0 ? "off" : ("1/" + std::to_string(rate)).c_str(), ns, ns - baseline);
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Cost per reported error during an error storm: Display<E>::print straight
+// to stderr (one write(2) per error, serialized on the stream lock) against
+// ErrorSink in All and Dedup mode, from one thread and from four, and from one
+// thread reporting to two sinks in turn. stderr goes to /dev/null while
+// measuring, so the numbers leave out the terminal.
+//
+//   make bench_error_sink && ./out/bench_error_sink --json error_sink.json
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "bench/bench.hpp"
+#include "error_sink.hpp"
+
+enum class StormError {
+    Timeout,
+    Refused,
+    Reset,
+};
+
+template<>
+struct Display<StormError> {
+    static void print(StormError e) {
+        static constexpr const char* names[] = { "timeout", "connection refused", "connection reset" };
+        std::fprintf(stderr, "upstream error: %s\n", names[static_cast<int>(e)]);
+    }
+};
+
+static auto storm_error(std::uint64_t i) -> StormError {
+    return static_cast<StormError>(i % 3);
+}
+
+// ns per error with `threads` threads reporting `per_thread` errors each
+template<typename Report>
+static auto storm(int threads, Report report) -> bench::Measurement {
+    constexpr std::uint64_t per_thread = 1 << 16;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (std::uint64_t i = 0; i < per_thread; ++i) {
+                report(storm_error(i));
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    auto n = per_thread * static_cast<std::uint64_t>(threads);
+    return bench::Measurement { ns / static_cast<double>(n), n, {} };
+}
+
+int main(int argc, char** argv) {
+    bench::Report report;
+    auto saved_stderr = dup(2);
+    auto null = open("/dev/null", O_WRONLY);
+    auto quiet = [&] { dup2(null, 2); };
+    auto loud = [&] { dup2(saved_stderr, 2); };
+    auto add = [&](const char* name, int threads, std::uint64_t dropped, bench::Measurement m) {
+        loud();
+        report.add(name, { { "threads", std::to_string(threads) }, { "dropped", std::to_string(dropped) } }, m);
+    };
+
+    quiet();
+    auto m = bench::measure([](std::uint64_t i) { Display<StormError>::print(storm_error(i)); });
+    add("display_print", 1, 0, m);
+
+    // The sink drains what is left when it is destroyed, still into /dev/null
+    auto with_sink = [&](SinkMode mode, int threads, auto&& run) {
+        quiet();
+        bench::Measurement m;
+        std::uint64_t dropped;
+        {
+            ErrorSink sink({ .mode = mode });
+            m = run(sink);
+            dropped = sink.dropped();
+        }
+        add(mode == SinkMode::All ? "sink_all" : "sink_dedup", threads, dropped, m);
+    };
+    for (auto mode : { SinkMode::All, SinkMode::Dedup }) {
+        with_sink(mode, 1, [](ErrorSink& sink) {
+            return bench::measure([&](std::uint64_t i) { sink.report(storm_error(i)); });
+        });
+    }
+
+    // One thread alternating between two sinks, e.g. a library's and the
+    // application's
+    quiet();
+    {
+        std::uint64_t dropped;
+        {
+            ErrorSink a({ .mode = SinkMode::Dedup });
+            ErrorSink b({ .mode = SinkMode::Dedup });
+            m = bench::measure([&](std::uint64_t i) { (i & 1 ? a : b).report(storm_error(i)); });
+            dropped = a.dropped() + b.dropped();
+        }
+        add("sink_dedup_two_sinks", 1, dropped, m);
+    }
+
+    quiet();
+    add("display_print", 4, 0, storm(4, [](StormError e) { Display<StormError>::print(e); }));
+    for (auto mode : { SinkMode::All, SinkMode::Dedup }) {
+        with_sink(mode, 4, [](ErrorSink& sink) {
+            return storm(4, [&](StormError e) { sink.report(e); });
+        });
+    }
+
+    close(null);
+    close(saved_stderr);
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
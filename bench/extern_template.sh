@@ -0,0 +1,158 @@
+#!/bin/sh
+# Compile time of a synthetic project of <tus> TUs that use Result with 16
+# error types, once with implicit instantiation in every TU, once with
+# RESULT_EXTERN_TEMPLATE in the shared header plus one RESULT_INSTANTIATE
+# TU, and once with the same declarations minus `extern template struct`,
+# so that only the free functions are extern. The TUs also call map and
+# and_then with named function objects from the header, which the extern
+# builds declare with RESULT_EXTERN_MAP and RESULT_EXTERN_AND_THEN. Prints
+# wall time, summed object size and the object files' symbol count for each
+# build.
+#
+#   usage: bench/extern_template.sh [cxx] [outdir] [tus] [opt]
+#
+# opt defaults to -O0. With optimization the extern builds also stop the
+# declared functions from being inlined.
+set -eu
+
+CXX=${1:-c++}
+OUT=${2:-./out}/extern_template
+TUS=${3:-500}
+OPT=${4:--O0}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+TYPES=16
+JOBS=$(nproc 2>/dev/null || echo 1)
+
+rm -rf "$OUT"
+mkdir -p "$OUT/src"
+OUT=$(cd "$OUT" && pwd)
+
+# errors.hpp: the error types, their Display, the shared function objects
+# and, with USE_EXTERN or USE_EXTERN_FUNCTIONS, the explicit instantiation
+# declarations
+{
+    echo '#pragma once'
+    echo '#include <cstdio>'
+    echo '#include <string>'
+    echo '#include "result.hpp"'
+    echo 'struct Doubled { auto operator()(int v) const -> int { return v * 2; } };'
+    k=0
+    while [ $k -lt $TYPES ]; do
+        echo "enum class E$k { NotFound, Invalid, Timeout };"
+        printf 'template<> struct Display<E%d> { static void print(E%d e) { std::fprintf(stderr, "E%d %%d\\n", static_cast<int>(e)); } };\n' $k $k $k
+        echo "struct Bounded$k { auto operator()(int v) const -> Result<int, E$k> { return v > 1000 ? err<int, E$k>(E$k::Invalid) : ok<int, E$k>(v); } };"
+        echo '#if defined(USE_EXTERN) || defined(USE_EXTERN_FUNCTIONS)'
+        echo "RESULT_EXTERN_MAP(int, E$k, Doubled);"
+        echo "RESULT_EXTERN_AND_THEN(int, E$k, Bounded$k);"
+        echo '#endif'
+        echo '#if defined(USE_EXTERN)'
+        echo "RESULT_EXTERN_TEMPLATE(int, E$k);"
+        echo "RESULT_EXTERN_TEMPLATE(std::string, E$k);"
+        echo "RESULT_EXTERN_TEMPLATE_VOID(E$k);"
+        echo '#elif defined(USE_EXTERN_FUNCTIONS)'
+        for t in int std::string; do
+            echo "extern template auto ok<$t, E$k>($t) -> Result<$t, E$k>;"
+            echo "extern template auto err<$t, E$k>(E$k, detail::SourceLocation) -> Result<$t, E$k>;"
+            echo "extern template auto detail::err_with_meta<$t, E$k>(E$k, detail::ErrorMeta) -> Result<$t, E$k>;"
+            echo "extern template $t unwrap<$t, E$k>(const Result<$t, E$k>&);"
+            echo "extern template $t unwrap<$t, E$k>(Result<$t, E$k>&&);"
+            echo "extern template $t unwrap_or<$t, E$k>(const Result<$t, E$k>&, $t);"
+        done
+        echo "extern template auto ok<E$k>() -> Result<void, E$k>;"
+        echo "extern template auto err<E$k>(E$k, detail::SourceLocation) -> Result<void, E$k>;"
+        echo "extern template void unwrap<E$k>(const Result<void, E$k>&);"
+        echo '#endif'
+        k=$((k + 1))
+    done
+} > "$OUT/src/errors.hpp"
+
+{
+    echo '#include "errors.hpp"'
+    k=0
+    while [ $k -lt $TYPES ]; do
+        echo "RESULT_INSTANTIATE(int, E$k);"
+        echo "RESULT_INSTANTIATE(std::string, E$k);"
+        echo "RESULT_INSTANTIATE_VOID(E$k);"
+        echo "RESULT_INSTANTIATE_MAP(int, E$k, Doubled);"
+        echo "RESULT_INSTANTIATE_AND_THEN(int, E$k, Bounded$k);"
+        k=$((k + 1))
+    done
+} > "$OUT/src/instantiate.cpp"
+
+# Each TU uses four of the error types through the unwrap family, map and
+# and_then
+i=0
+while [ $i -lt "$TUS" ]; do
+    {
+        echo '#include "errors.hpp"'
+        j=0
+        while [ $j -lt 4 ]; do
+            k=$(((i + j * 5) % TYPES))
+            cat <<CPP
+static auto find_${j}(int x) -> Result<int, E$k> {
+    if (x < 0) {
+        return err<int, E$k>(E$k::NotFound);
+    }
+    return ok<int, E$k>(x * $i);
+}
+
+static auto name_${j}(int x) -> Result<std::string, E$k> {
+    if (x > 1000) {
+        return err<std::string, E$k>(E$k::Invalid);
+    }
+    return ok<std::string, E$k>(std::to_string(x));
+}
+
+static auto check_${j}(int x) -> Result<void, E$k> {
+    if (x == 7) {
+        return err<void, E$k>(E$k::Timeout);
+    }
+    return ok<E$k>();
+}
+
+CPP
+            j=$((j + 1))
+        done
+        echo "auto use_$i(int x) -> int {"
+        echo '    int total = 0;'
+        j=0
+        while [ $j -lt 4 ]; do
+            k=$(((i + j * 5) % TYPES))
+            echo "    total += unwrap_or(find_$j(x), 0) + static_cast<int>(unwrap(name_$j(x)).size());"
+            echo "    total += unwrap_or(find_$j(x).map(Doubled {}).and_then(Bounded$k {}), 0);"
+            echo "    auto copy_$j = find_$j(x + 1);"
+            echo "    total += unwrap(copy_$j);"
+            echo "    unwrap(check_$j(x));"
+            j=$((j + 1))
+        done
+        echo '    return total;'
+        echo '}'
+    } > "$OUT/src/tu_$i.cpp"
+    i=$((i + 1))
+done
+
+now() {
+    date +%s.%N
+}
+
+# build <name> <extra flags> <sources...>: compiles in parallel, prints a row
+build() {
+    name=$1
+    flags=$2
+    shift 2
+    dir=$OUT/$name
+    mkdir -p "$dir"
+    start=$(now)
+    for src in "$@"; do
+        echo "$src"
+    done | xargs -P "$JOBS" -I{} sh -c "$CXX -std=c++20 $OPT -g -I'$ROOT' $flags -c '{}' -o '$dir'/\$(basename '{}' .cpp).o"
+    end=$(now)
+    bytes=$(cat "$dir"/*.o | wc -c)
+    symbols=$(nm "$dir"/*.o | grep -c ' [TW] ' || true)
+    printf '%-10s %5d TUs %8.2f s %12d bytes %8d symbols\n' "$name" "$#" "$(awk "BEGIN { print $end - $start }")" "$bytes" "$symbols"
+}
+
+set -- "$OUT"/src/tu_*.cpp
+build implicit "" "$@"
+build extern "-DRESULT_EXTERN_TEMPLATE_ENABLE=1 -DUSE_EXTERN" "$@" "$OUT/src/instantiate.cpp"
+build functions "-DRESULT_EXTERN_TEMPLATE_ENABLE=1 -DUSE_EXTERN_FUNCTIONS" "$@" "$OUT/src/instantiate.cpp"
@@ -0,0 +1,102 @@
+// Random 4 KiB reads from a 64 MiB file: one pread per read against IoRing
+// with `depth` reads submitted and reaped per io_uring_enter, and against
+// the IoRing pread fallback. Each configuration runs on the page cache and,
+// where the filesystem supports it, with O_DIRECT, which is where deeper
+// queues let the device overlap requests.
+//
+//   make bench_io_ring && ./out/bench_io_ring --json io_ring.json
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "bench/bench.hpp"
+#include "io_ring.hpp"
+
+constexpr std::size_t file_bytes = 64 * 1024 * 1024;
+constexpr std::size_t block = 4096;
+constexpr std::size_t max_depth = 64;
+
+static auto add(bench::Report& report, const char* name, unsigned depth, bool direct, bench::Measurement m) -> void {
+    report.add(name, { { "depth", std::to_string(depth) }, { "direct", direct ? "yes" : "no" } }, m);
+}
+
+int main(int argc, char** argv) {
+    char path[] = "/var/tmp/bench_io_ring_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        return 1;
+    }
+    std::vector<char> chunk(1 << 20, 'x');
+    for (std::size_t written = 0; written < file_bytes; written += chunk.size()) {
+        if (write(fd, chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size())) {
+            std::perror("write");
+            return 1;
+        }
+    }
+    fsync(fd);
+
+    std::mt19937_64 rng(7);
+    std::vector<std::uint64_t> offsets(1 << 16);
+    for (auto& o : offsets) {
+        o = rng() % (file_bytes / block) * block;
+    }
+    auto offset = [&](std::uint64_t i) { return offsets[i & (offsets.size() - 1)]; };
+
+    auto bufs = static_cast<char*>(std::aligned_alloc(block, block * max_depth));
+    std::size_t bytes = 0;
+    auto reap = [&](IoHandle, Result<std::size_t, IoError> r) { bytes += unwrap(std::move(r)); };
+    bench::Report report;
+
+    for (bool direct : { false, true }) {
+        int rfd = open(path, O_RDONLY | (direct ? O_DIRECT : 0));
+        if (rfd < 0) {
+            std::fprintf(stderr, "skipping O_DIRECT runs: filesystem does not support it\n");
+            continue;
+        }
+
+        auto m = bench::measure([&](std::uint64_t i) {
+            bytes += static_cast<std::size_t>(pread(rfd, bufs, block, static_cast<off_t>(offset(i))));
+        });
+        add(report, "pread", 1, direct, m);
+
+        for (auto backend : { IoBackend::IoUring, IoBackend::Sync }) {
+            for (unsigned depth : { 1, 4, 16, 64 }) {
+                IoRing ring(depth, backend);
+                if (ring.backend() != backend) {
+                    std::fprintf(stderr, "skipping io_uring runs: io_uring_setup failed\n");
+                    break;
+                }
+                // One batch of `depth` reads per depth iterations, so ns/op is per read
+                auto m = bench::measure([&](std::uint64_t i) {
+                    if (i % depth != 0) {
+                        return;
+                    }
+                    for (unsigned d = 0; d < depth; ++d) {
+                        unwrap(ring.read(rfd, bufs + d * block, block, offset(i + d)));
+                    }
+                    unwrap(ring.wait(depth, reap));
+                });
+                add(report, backend == IoBackend::IoUring ? "io_ring" : "io_ring_sync", depth, direct, m);
+            }
+        }
+        close(rfd);
+    }
+    bench::do_not_optimize(bytes);
+
+    std::free(bufs);
+    close(fd);
+    unlink(path);
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
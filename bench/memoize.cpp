@@ -0,0 +1,66 @@
+// Memoized Result-returning lookups: a hit returning a small value by copy
+// and a large one as a shared_ptr, against calling a 1 µs lookup directly,
+// and with a key space twice the capacity so that CLOCK evicts on every
+// other call.
+//
+//   make bench_memoize && ./out/bench_memoize --json memoize.json
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "bench/bench.hpp"
+#include "memoize.hpp"
+
+enum class LookupError {
+    NotFound,
+};
+
+// Stands in for a remote or disk lookup; every tenth key does not exist
+static auto slow_lookup(const int& key) -> Result<std::int64_t, LookupError> {
+    auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(1);
+    while (std::chrono::steady_clock::now() < until) {}
+    if (key % 10 == 0) {
+        return err<std::int64_t, LookupError>(LookupError::NotFound);
+    }
+    return ok<std::int64_t, LookupError>(std::int64_t(key) * 3);
+}
+
+static auto slow_name(const int& key) -> Result<std::string, LookupError> {
+    auto value = slow_lookup(key);
+    if (value.tag == Result<std::int64_t, LookupError>::Tag::Err) {
+        return err<std::string, LookupError>(value.error);
+    }
+    return ok<std::string, LookupError>("a cached value longer than the small string buffer #" + std::to_string(value.value));
+}
+
+int main(int argc, char** argv) {
+    constexpr int keys = 1024;
+    bench::Report report;
+    auto add = [&](const char* name, int key_space, bench::Measurement m) {
+        report.add(name, { { "keys", std::to_string(key_space) } }, m);
+    };
+
+    add("direct", keys, bench::measure([](std::uint64_t i) { bench::do_not_optimize(slow_lookup(static_cast<int>(i % keys))); }));
+
+    auto small = memoize<int>(&slow_lookup, { .capacity = 4 * keys });
+    add("memo_hit_copy", keys, bench::measure([&](std::uint64_t i) { bench::do_not_optimize(small(static_cast<int>(i % keys))); }));
+
+    auto large = memoize<int>(&slow_name, { .capacity = 4 * keys });
+    add("memo_hit_shared", keys, bench::measure([&](std::uint64_t i) { bench::do_not_optimize(large(static_cast<int>(i % keys))); }));
+
+    // Half the calls miss, and each miss evicts
+    auto churn = memoize<int>(&slow_lookup, { .capacity = keys, .shards = 4 });
+    std::uint64_t state = 1;
+    add("memo_evicting", 2 * keys, bench::measure([&](std::uint64_t) {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        bench::do_not_optimize(churn(static_cast<int>((state >> 33) % (2 * keys))));
+    }));
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
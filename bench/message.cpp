@@ -0,0 +1,108 @@
+// Errors carrying a message: std::string against InlineMessage (formatted
+// eagerly into a fixed buffer) and LazyMessage (arguments captured, rendered
+// only when printed), propagated through a few calls under error storms.
+// Most errors are handled without being shown; `render_every` controls how
+// often the caller does format the message, e.g. to log it.
+//
+//   make bench_message && ./out/bench_message --json message.json
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include "bench/bench.hpp"
+#include "message.hpp"
+#include "result.hpp"
+
+template<>
+struct Display<std::string> {
+    static void print(const std::string& s) {
+        std::fprintf(stderr, "%s\n", s.c_str());
+    }
+};
+
+constexpr std::size_t pattern_size = 4096;
+static std::uint8_t fail_pattern[pattern_size];
+
+static auto set_error_rate(int percent) -> void {
+    for (std::size_t i = 0; i < pattern_size; ++i) {
+        fail_pattern[i] = i * 100 < pattern_size * static_cast<std::size_t>(percent);
+    }
+    std::shuffle(fail_pattern, fail_pattern + pattern_size, std::mt19937(7));
+}
+
+template<typename E>
+static auto make_error(std::uint64_t i) -> E {
+    auto key = static_cast<unsigned>(i & 0xffff);
+    if constexpr (std::is_same_v<E, std::string>) {
+        return "lookup failed for key " + std::to_string(key) + " in table users";
+    } else if constexpr (std::is_same_v<E, InlineMessage<>>) {
+        return InlineMessage<>::format("lookup failed for key %u in table %s", key, "users");
+    } else {
+        return lazy_message("lookup failed for key %u in table %s", key, "users");
+    }
+}
+
+template<typename E>
+static auto message_size(const E& e) -> std::size_t {
+    if constexpr (std::is_same_v<E, std::string>) {
+        return e.size();
+    } else if constexpr (std::is_same_v<E, InlineMessage<>>) {
+        return e.size();
+    } else {
+        return e.render().size();
+    }
+}
+
+template<typename E>
+[[gnu::noinline]] static auto leaf(std::uint64_t i) -> Result<int, E> {
+    if (fail_pattern[i & (pattern_size - 1)]) {
+        return err<int, E>(make_error<E>(i));
+    }
+    return ok<int, E>(static_cast<int>(i));
+}
+
+template<typename E, int Depth>
+[[gnu::noinline]] static auto call(std::uint64_t i) -> Result<int, E> {
+    if constexpr (Depth == 1) {
+        return leaf<E>(i);
+    } else {
+        return call<E, Depth - 1>(i).map([] (int v) { return v + 1; });
+    }
+}
+
+template<typename E>
+static auto bench_message(bench::Report& report, const char* name, int rate, std::uint64_t render_every) -> void {
+    auto m = bench::measure([render_every] (std::uint64_t i) {
+        auto r = call<E, 4>(i);
+        if (r.tag == Result<int, E>::Tag::Err && render_every != 0 && i % render_every == 0) {
+            bench::do_not_optimize(message_size(r.error));
+        }
+        bench::do_not_optimize(r.tag);
+    });
+    report.add(name, {
+        { "error_rate", std::to_string(rate) },
+        { "render_every", std::to_string(render_every) },
+        { "result_size", std::to_string(sizeof(Result<int, E>)) },
+    }, m);
+}
+
+int main(int argc, char** argv) {
+    bench::Report report;
+    for (int rate : { 0, 10, 20, 30, 40, 50 }) {
+        set_error_rate(rate);
+        for (std::uint64_t render_every : { 0, 100, 1 }) {
+            bench_message<std::string>(report, "std_string", rate, render_every);
+            bench_message<InlineMessage<>>(report, "inline_message", rate, render_every);
+            bench_message<LazyMessage<>>(report, "lazy_message", rate, render_every);
+        }
+    }
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
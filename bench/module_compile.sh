@@ -0,0 +1,127 @@
+#!/bin/sh
+# Compile time of <tus> TUs that use Result, once including result.hpp and
+# once importing the result module built from result.cppm. The module build
+# includes compiling the module interface itself. Both builds are linked and
+# run, so a broken module fails the benchmark.
+#
+#   usage: bench/module_compile.sh [cxx] [outdir] [tus] [opt]
+#
+# clang++ uses --precompile and -fmodule-file; g++ uses -fmodules-ts and its
+# gcm.cache in the build directory.
+set -eu
+
+CXX=${1:-clang++}
+OUT=${2:-./out}/module_compile
+TUS=${3:-200}
+OPT=${4:--O0}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+JOBS=$(nproc 2>/dev/null || echo 1)
+
+rm -rf "$OUT"
+mkdir -p "$OUT/src"
+OUT=$(cd "$OUT" && pwd)
+
+if $CXX --version | grep -q clang; then
+    MODULE=clang
+else
+    MODULE=gcc
+fi
+
+# Each TU has its own error type and uses it through the usual calls. The
+# #ifdef is the header fallback a project would use during the migration.
+i=0
+while [ $i -lt "$TUS" ]; do
+    cat > "$OUT/src/tu_$i.cpp" <<CPP
+#include <cstdio>
+#ifdef USE_MODULE
+import result;
+#else
+#include "result.hpp"
+#endif
+
+enum class Error$i { NotFound, Invalid };
+
+template<>
+struct Display<Error$i> {
+    static void print(Error$i e) {
+        std::fprintf(stderr, "tu $i: error %d\n", static_cast<int>(e));
+    }
+};
+
+static auto find(int x) -> Result<int, Error$i> {
+    if (x < 0) {
+        return err<int, Error$i>(Error$i::NotFound);
+    }
+    return ok<int, Error$i>(x + $i);
+}
+
+static auto check(int x) -> Result<void, Error$i> {
+    if (x > 1000) {
+        return err<void, Error$i>(Error$i::Invalid);
+    }
+    return ok<Error$i>();
+}
+
+auto use_$i(int x) -> int {
+    unwrap(check(x));
+    auto doubled = find(x).map([](int v) { return v * 2; });
+    return unwrap_or(find(-x - 1), 0) + match(doubled, [](int v) { return v; }, [](Error$i) { return -1; });
+}
+CPP
+    i=$((i + 1))
+done
+
+{
+    i=0
+    while [ $i -lt "$TUS" ]; do
+        echo "auto use_$i(int x) -> int;"
+        i=$((i + 1))
+    done
+    echo 'int main() {'
+    echo '    long total = 0;'
+    i=0
+    while [ $i -lt "$TUS" ]; do
+        echo "    total += use_$i(1);"
+        i=$((i + 1))
+    done
+    echo '    return total > 0 ? 0 : 1;'
+    echo '}'
+} > "$OUT/src/main.cpp"
+
+now() {
+    date +%s.%N
+}
+
+# compile <dir> <flags>: compiles every TU in dir, in parallel
+compile() {
+    for src in "$OUT"/src/tu_*.cpp "$OUT/src/main.cpp"; do
+        echo "$src"
+    done | xargs -P "$JOBS" -I{} sh -c "cd '$1' && $CXX -std=c++20 $OPT $2 -c '{}' -o \$(basename '{}' .cpp).o"
+}
+
+row() {
+    printf '%-8s %5d TUs %8.2f s %8.1f ms/TU\n' "$1" "$TUS" "$(awk "BEGIN { print $3 - $2 }")" "$(awk "BEGIN { print ($3 - $2) * 1000 / $TUS }")"
+}
+
+dir=$OUT/header
+mkdir -p "$dir"
+start=$(now)
+compile "$dir" "-I'$ROOT'"
+end=$(now)
+$CXX "$dir"/*.o -o "$dir/run" && "$dir/run"
+row header "$start" "$end"
+
+dir=$OUT/module
+mkdir -p "$dir"
+start=$(now)
+if [ $MODULE = clang ]; then
+    (cd "$dir" && $CXX -std=c++20 $OPT -I"$ROOT" --precompile "$ROOT/result.cppm" -o result.pcm)
+    (cd "$dir" && $CXX -std=c++20 $OPT -c result.pcm -o result.o)
+    compile "$dir" "-DUSE_MODULE -fmodule-file=result='$dir/result.pcm'"
+else
+    (cd "$dir" && $CXX -std=c++20 $OPT -fmodules-ts -I"$ROOT" -x c++ -c "$ROOT/result.cppm" -o result.o)
+    compile "$dir" "-DUSE_MODULE -fmodules-ts"
+fi
+end=$(now)
+$CXX "$dir"/*.o -o "$dir/run" && "$dir/run"
+row module "$start" "$end"
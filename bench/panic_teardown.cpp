@@ -0,0 +1,103 @@
+// Process teardown latency of each panic policy: time from the panic call in
+// a forked child until the parent's waitpid returns. The child carries some
+// typical shutdown work: atexit handlers, a static container to destroy and
+// buffered output to flush.
+//
+//   make bench_panic && ./out/bench_panic --json panic.json
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "bench/bench.hpp"
+#include "result.hpp"
+
+extern "C" void result_panic_hook() {
+    std::_Exit(1);
+}
+
+static auto now_ns() -> std::int64_t {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+static std::vector<std::string> static_state;
+
+static auto prepare_shutdown_work() -> void {
+    for (int i = 0; i < 256; ++i) {
+        std::atexit([] { bench::do_not_optimize(static_state.size()); });
+    }
+    static_state.reserve(100'000);
+    for (int i = 0; i < 100'000; ++i) {
+        static_state.push_back(std::string(48, static_cast<char>('a' + i % 26)));
+    }
+    if (std::freopen("/dev/null", "w", stdout) != nullptr) {
+        for (int i = 0; i < 4096; ++i) {
+            std::fputs("buffered line that must be flushed on a clean exit\n", stdout);
+        }
+    }
+}
+
+template<int Policy>
+static auto teardown_ns(std::atomic<std::int64_t>* shared) -> std::int64_t {
+    auto pid = fork();
+    if (pid == 0) {
+        rlimit no_core { 0, 0 };
+        setrlimit(RLIMIT_CORE, &no_core);
+        prepare_shutdown_work();
+        shared->store(now_ns());
+        detail::panic<Policy>();
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return now_ns() - shared->load();
+}
+
+template<int Policy>
+static auto bench_policy(bench::Report& report, const char* name, std::atomic<std::int64_t>* shared) -> void {
+    constexpr int runs = 25;
+    std::vector<std::int64_t> samples;
+    for (int i = 0; i < runs; ++i) {
+        samples.push_back(teardown_ns<Policy>(shared));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    report.add("panic_teardown", { { "policy", name } }, bench::Measurement {
+        static_cast<double>(samples[runs / 2]), runs, {}
+    });
+}
+
+int main(int argc, char** argv) {
+    auto page = mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+        std::perror("mmap");
+        return 1;
+    }
+    auto shared = new (page) std::atomic<std::int64_t>(0);
+
+    bench::Report report;
+    bench_policy<RESULT_PANIC_EXIT>(report, "exit", shared);
+    bench_policy<RESULT_PANIC_QUICK_EXIT>(report, "quick_exit", shared);
+    bench_policy<RESULT_PANIC_FAST_EXIT>(report, "fast_exit", shared);
+    bench_policy<RESULT_PANIC_ABORT>(report, "abort", shared);
+    bench_policy<RESULT_PANIC_TRAP>(report, "trap", shared);
+    bench_policy<RESULT_PANIC_HOOK>(report, "hook", shared);
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+// parse<T>(string_view) against the parse_int the example used to carry
+// (isdigit scan, then std::stoi on a std::string) and against std::stod,
+// over inputs sliced out of one buffer at several error rates.
+//
+//   make bench_parse && ./out/bench_parse --json parse.json
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bench/bench.hpp"
+#include "parse.hpp"
+#include "result.hpp"
+
+// The implementation parse.hpp replaces, kept verbatim as the baseline
+static auto example_parse_int(const std::string& s) -> Result<int, ParseError> {
+    if (s.empty()) {
+        return err<int, ParseError>(ParseError::Empty);
+    }
+
+    for (char c : s) {
+        if (!isdigit(c)) {
+            return err<int, ParseError>(ParseError::NotANumber);
+        }
+    }
+
+    return ok<int, ParseError>(std::stoi(s));
+}
+
+static auto stod_parse_double(const std::string& s) -> Result<double, ParseError> {
+    if (s.empty()) {
+        return err<double, ParseError>(ParseError::Empty);
+    }
+    try {
+        std::size_t used = 0;
+        auto d = std::stod(s, &used);
+        if (used != s.size()) {
+            return err<double, ParseError>(ParseError::NotANumber);
+        }
+        return ok<double, ParseError>(d);
+    } catch (const std::out_of_range&) {
+        return err<double, ParseError>(ParseError::Overflow);
+    } catch (const std::invalid_argument&) {
+        return err<double, ParseError>(ParseError::NotANumber);
+    }
+}
+
+constexpr std::size_t input_count = 4096;
+
+struct Inputs {
+    std::string buffer;
+    std::vector<std::string_view> fields;
+};
+
+// Comma-separated fields in one buffer, like a line of a CSV file. Invalid
+// fields have a letter in the middle.
+static auto make_inputs(bool floating, int error_percent) -> Inputs {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> digits(1, 9);
+    std::uniform_int_distribution<int> percent(0, 99);
+    Inputs in;
+    std::vector<std::pair<std::size_t, std::size_t>> spans;
+    for (std::size_t i = 0; i < input_count; ++i) {
+        auto begin = in.buffer.size();
+        auto n = digits(rng);
+        for (int d = 0; d < n; ++d) {
+            in.buffer += static_cast<char>('0' + rng() % 10);
+        }
+        if (floating) {
+            in.buffer += '.';
+            in.buffer += std::to_string(rng() % 1000);
+        }
+        if (percent(rng) < error_percent) {
+            in.buffer[begin + (in.buffer.size() - begin) / 2] = 'x';
+        }
+        spans.emplace_back(begin, in.buffer.size() - begin);
+        in.buffer += ',';
+    }
+    for (auto [begin, size] : spans) {
+        in.fields.emplace_back(in.buffer.data() + begin, size);
+    }
+    return in;
+}
+
+template<typename F>
+static auto bench_parse(bench::Report& report, const char* name, const Inputs& in, int rate, F parse_field) -> void {
+    auto m = bench::measure([&] (std::uint64_t i) {
+        auto r = parse_field(in.fields[i & (input_count - 1)]);
+        bench::do_not_optimize(r);
+    });
+    report.add(name, { { "error_rate", std::to_string(rate) } }, m);
+}
+
+int main(int argc, char** argv) {
+    bench::Report report;
+    for (int rate : { 0, 10, 50 }) {
+        auto ints = make_inputs(false, rate);
+        bench_parse(report, "example_parse_int", ints, rate, [] (std::string_view s) {
+            return example_parse_int(std::string(s));
+        });
+        bench_parse(report, "parse<int>", ints, rate, [] (std::string_view s) {
+            return parse<int>(s);
+        });
+        bench_parse(report, "parse<int64_t>", ints, rate, [] (std::string_view s) {
+            return parse<std::int64_t>(s);
+        });
+
+        auto doubles = make_inputs(true, rate);
+        bench_parse(report, "stod", doubles, rate, [] (std::string_view s) {
+            return stod_parse_double(std::string(s));
+        });
+        bench_parse(report, "parse<double>", doubles, rate, [] (std::string_view s) {
+            return parse<double>(s);
+        });
+    }
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
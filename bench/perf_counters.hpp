@@ -0,0 +1,174 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "result.hpp"
+
+// Hardware performance counters through perf_event_open (Linux only).
+// All counters are opened as one group so they cover the same interval.
+
+enum class PerfError {
+    Unsupported,
+    PermissionDenied,
+    OpenFailed,
+    ReadFailed,
+};
+
+template<>
+struct Display<PerfError> {
+    static void print(PerfError e) {
+        switch(e) {
+            case PerfError::Unsupported: std::fputs("perf: hardware counters not supported\n", stderr); break;
+            case PerfError::PermissionDenied: std::fputs("perf: permission denied (see /proc/sys/kernel/perf_event_paranoid)\n", stderr); break;
+            case PerfError::OpenFailed: std::fputs("perf: perf_event_open failed\n", stderr); break;
+            case PerfError::ReadFailed: std::fputs("perf: reading counters failed\n", stderr); break;
+        }
+    }
+};
+
+enum class Counter {
+    Cycles,
+    Instructions,
+    BranchMisses,
+    L1iMisses,
+    Count,
+};
+
+struct Counters {
+    std::uint64_t values[static_cast<int>(Counter::Count)];
+    std::uint32_t available; // bit per Counter
+
+    auto has(Counter c) const -> bool {
+        return available & (1u << static_cast<int>(c));
+    }
+
+    auto operator[](Counter c) const -> std::uint64_t {
+        return values[static_cast<int>(c)];
+    }
+};
+
+// Plain handle over the group's file descriptors, call close() when done
+struct PerfGroup {
+    int fds[static_cast<int>(Counter::Count)];
+
+    auto start() const -> void {
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    auto stop() const -> void {
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Values are scaled up if the kernel multiplexed the group
+    auto read() const -> Result<Counters, PerfError> {
+        constexpr int n = static_cast<int>(Counter::Count);
+        struct {
+            std::uint64_t nr;
+            std::uint64_t time_enabled;
+            std::uint64_t time_running;
+            std::uint64_t values[n];
+        } data {};
+
+        if (::read(fds[0], &data, sizeof(data)) <= 0) {
+            return err<Counters, PerfError>(PerfError::ReadFailed);
+        }
+
+        auto scale = data.time_running == 0 ? 0.0 : static_cast<double>(data.time_enabled) / static_cast<double>(data.time_running);
+        Counters c {};
+        std::uint64_t slot = 0;
+        for (int i = 0; i < n && slot < data.nr; ++i) {
+            if (fds[i] < 0) {
+                continue;
+            }
+            c.values[i] = static_cast<std::uint64_t>(static_cast<double>(data.values[slot++]) * scale);
+            c.available |= 1u << i;
+        }
+
+        return ok<Counters, PerfError>(c);
+    }
+
+    auto close() -> void {
+        for (auto& fd : fds) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+    }
+};
+
+namespace detail {
+
+inline auto perf_event_open(perf_event_attr& attr, int group_fd) -> int {
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+inline auto perf_attr(Counter c) -> perf_event_attr {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = c == Counter::Cycles;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (c) {
+        case Counter::Cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case Counter::Instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case Counter::BranchMisses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case Counter::L1iMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1I | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case Counter::Count:
+            break;
+    }
+
+    return attr;
+}
+
+} // namespace detail
+
+// Open cycles as group leader plus whichever of the other counters the
+// CPU supports. Fails only when the leader itself cannot be opened.
+inline auto open_perf_group() -> Result<PerfGroup, PerfError> {
+    PerfGroup group;
+    for (auto& fd : group.fds) {
+        fd = -1;
+    }
+
+    auto leader_attr = detail::perf_attr(Counter::Cycles);
+    group.fds[0] = detail::perf_event_open(leader_attr, -1);
+    if (group.fds[0] < 0) {
+        switch (errno) {
+            case ENOENT:
+            case ENOSYS:
+            case EOPNOTSUPP: return err<PerfGroup, PerfError>(PerfError::Unsupported);
+            case EACCES:
+            case EPERM: return err<PerfGroup, PerfError>(PerfError::PermissionDenied);
+            default: return err<PerfGroup, PerfError>(PerfError::OpenFailed);
+        }
+    }
+
+    for (int i = 1; i < static_cast<int>(Counter::Count); ++i) {
+        auto attr = detail::perf_attr(static_cast<Counter>(i));
+        group.fds[i] = detail::perf_event_open(attr, group.fds[0]);
+    }
+
+    return ok<PerfGroup, PerfError>(group);
+}
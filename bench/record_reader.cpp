@@ -0,0 +1,144 @@
+// Per-record cost of reading a CSV file with RecordReader against
+// std::getline on an std::ifstream and against splitting a MappedFile,
+// parsing the first column of each row with parse<std::int64_t>. Both rewind at the end of the file, so the
+// file stays in the page cache and only the reading path is measured.
+//
+//   make bench_record_reader && ./out/bench_record_reader --json record_reader.json
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include "bench/bench.hpp"
+#include "mapped_file.hpp"
+#include "parse.hpp"
+#include "record_reader.hpp"
+
+constexpr std::size_t file_bytes = 32 * 1024 * 1024;
+
+// Rows like "12345,user_42,0.5", returns the average row length
+static auto write_csv(int fd) -> double {
+    std::mt19937 rng(5);
+    std::string chunk;
+    std::size_t rows = 0;
+    std::size_t written = 0;
+    while (written < file_bytes) {
+        chunk.clear();
+        while (chunk.size() < 1 << 16) {
+            chunk += std::to_string(rng() % 1000000);
+            chunk += ",user_";
+            chunk += std::to_string(rng() % 5000);
+            chunk += ",0.";
+            chunk += std::to_string(rng() % 1000);
+            chunk += '\n';
+            ++rows;
+        }
+        if (write(fd, chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size())) {
+            std::perror("write");
+            std::exit(1);
+        }
+        written += chunk.size();
+    }
+    return static_cast<double>(written) / static_cast<double>(rows);
+}
+
+static auto first_column(std::string_view row) -> Result<std::int64_t, ParseError> {
+    return parse<std::int64_t>(row.substr(0, row.find(',')));
+}
+
+static auto add(bench::Report& report, const char* name, std::size_t buffer, double row_bytes, bench::Measurement m) -> void {
+    char mbps[32];
+    std::snprintf(mbps, sizeof(mbps), "%.0f", row_bytes / m.ns_per_op * 1000.0);
+    report.add(name, { { "buffer", std::to_string(buffer) }, { "mb_per_s", mbps } }, m);
+}
+
+int main(int argc, char** argv) {
+    char path[] = "/tmp/bench_record_reader_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        return 1;
+    }
+    auto row_bytes = write_csv(fd);
+    bench::Report report;
+
+    {
+        std::ifstream in(path);
+        std::string line;
+        auto m = bench::measure([&] (std::uint64_t) {
+            if (!std::getline(in, line)) {
+                in.clear();
+                in.seekg(0);
+                std::getline(in, line);
+            }
+            bench::do_not_optimize(first_column(line));
+        });
+        add(report, "getline", 0, row_bytes, m);
+    }
+
+    for (std::size_t buffer : { 4096, 64 * 1024, 1024 * 1024 }) {
+        lseek(fd, 0, SEEK_SET);
+        auto reader = std::make_unique<RecordReader>(fd, '\n', buffer);
+        auto m = bench::measure([&] (std::uint64_t) {
+            auto row = reader->next();
+            if (!row) {
+                lseek(fd, 0, SEEK_SET);
+                reader = std::make_unique<RecordReader>(fd, '\n', buffer);
+                row = reader->next();
+            }
+            bench::do_not_optimize(first_column(*row));
+        });
+        add(report, "record_reader", buffer, row_bytes, m);
+    }
+
+    // The same through the lazy range interface
+    {
+        lseek(fd, 0, SEEK_SET);
+        auto reader = std::make_unique<RecordReader>(fd);
+        auto range = std::make_unique<RecordRange<decltype(&first_column)>>(reader->records(&first_column));
+        auto it = range->begin();
+        auto m = bench::measure([&] (std::uint64_t) {
+            if (it == range->end()) {
+                lseek(fd, 0, SEEK_SET);
+                reader = std::make_unique<RecordReader>(fd);
+                range = std::make_unique<RecordRange<decltype(&first_column)>>(reader->records(&first_column));
+                it = range->begin();
+            }
+            bench::do_not_optimize(*it);
+            ++it;
+        });
+        add(report, "records_range", RecordReader::default_capacity, row_bytes, m);
+    }
+
+    // Zero-copy: rows are views straight into the mapping
+    {
+        auto file = unwrap(MappedFile::open(path));
+        (void)file.advise(Advice::Sequential);
+        auto text = file.text();
+        std::size_t pos = 0;
+        auto m = bench::measure([&] (std::uint64_t) {
+            if (pos >= text.size()) {
+                pos = 0;
+            }
+            auto end = text.find('\n', pos);
+            bench::do_not_optimize(first_column(text.substr(pos, end - pos)));
+            pos = end + 1;
+        });
+        add(report, "mapped_file", 0, row_bytes, m);
+    }
+
+    close(fd);
+    unlink(path);
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
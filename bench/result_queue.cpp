@@ -0,0 +1,196 @@
+// Moving Result<std::int64_t, E> items between threads: MpmcQueue with 1-16
+// producers and one consumer, SpscQueue with one of each, against the
+// mutex-guarded std::deque with a condition variable that pipelines use
+// today. Throughput rows report ns per item end to end; the latency rows
+// bounce one item between two threads and report ns per round trip.
+//
+//   make bench_result_queue && ./out/bench_result_queue --json result_queue.json
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench/bench.hpp"
+#include "result_queue.hpp"
+
+enum class StageError {
+    Bad,
+    Done,
+};
+
+using Item = Result<std::int64_t, StageError>;
+
+constexpr std::int64_t items = 1 << 20;
+constexpr std::size_t queue_size = 1024;
+
+// The baseline: unbounded, one lock for both ends
+class MutexQueue {
+public:
+    auto push(Item item) -> void {
+        {
+            std::lock_guard lock(mutex);
+            queue.push_back(item);
+        }
+        ready.notify_one();
+    }
+
+    auto close() -> void {
+        {
+            std::lock_guard lock(mutex);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+
+    // False once closed and drained
+    auto pop(Item& out) -> bool {
+        std::unique_lock lock(mutex);
+        ready.wait(lock, [&] { return !queue.empty() || closed; });
+        if (queue.empty()) {
+            return false;
+        }
+        out = queue.front();
+        queue.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Item> queue;
+    bool closed = false;
+};
+
+static auto item(std::int64_t i) -> Item {
+    return i % 64 == 0 ? err<std::int64_t, StageError>(StageError::Bad) : ok<std::int64_t, StageError>(i);
+}
+
+// Best of three runs of `producers` threads pushing `items` in total to a
+// fresh queue while one consumer drains it; ns per item
+template<typename Queue, typename Push, typename Drain>
+static auto throughput(int producers, Push push, Drain drain) -> bench::Measurement {
+    double best = 0;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        auto queue = std::make_unique<Queue>();
+        std::int64_t sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer([&] { sum = drain(*queue); });
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (std::int64_t i = p; i < items; i += producers) {
+                    push(*queue, item(i));
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        queue->close(StageError::Done);
+        consumer.join();
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        bench::do_not_optimize(sum);
+        if (repeat == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return bench::Measurement { best / items, static_cast<std::uint64_t>(items), {} };
+}
+
+// Best of three runs bouncing one item `rounds` times between two threads
+// through a pair of queues; ns per round trip
+template<typename Queue, typename Push, typename Pop>
+static auto round_trip(Push push, Pop pop) -> bench::Measurement {
+    constexpr std::int64_t rounds = 1 << 14;
+    double best = 0;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        auto ping = std::make_unique<Queue>();
+        auto pong = std::make_unique<Queue>();
+        auto start = std::chrono::steady_clock::now();
+        std::thread echo([&] {
+            for (std::int64_t i = 0; i < rounds; ++i) {
+                push(*pong, pop(*ping));
+            }
+        });
+        for (std::int64_t i = 0; i < rounds; ++i) {
+            push(*ping, item(i));
+            bench::do_not_optimize(pop(*pong));
+        }
+        echo.join();
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (repeat == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return bench::Measurement { best / rounds, static_cast<std::uint64_t>(rounds), {} };
+}
+
+struct Mpmc : MpmcQueue<std::int64_t, StageError> {
+    Mpmc() : MpmcQueue(queue_size) {}
+};
+
+struct Spsc : SpscQueue<std::int64_t, StageError> {
+    Spsc() : SpscQueue(queue_size) {}
+};
+
+struct Mutex : MutexQueue {
+    auto close(StageError) -> void {
+        MutexQueue::close();
+    }
+};
+
+// Sums the Ok values until the terminal error
+template<typename Queue>
+static auto drain(Queue& q) -> std::int64_t {
+    std::int64_t sum = 0;
+    for (auto next = q.pop(); next.tag == decltype(next)::Tag::Ok; next = q.pop()) {
+        sum += next.value.tag == Item::Tag::Ok ? next.value.value : 0;
+    }
+    return sum;
+}
+
+static auto drain_mutex(Mutex& q) -> std::int64_t {
+    std::int64_t sum = 0;
+    Item next;
+    while (q.pop(next)) {
+        sum += next.tag == Item::Tag::Ok ? next.value : 0;
+    }
+    return sum;
+}
+
+static auto add(bench::Report& report, const char* name, int producers, bench::Measurement m) -> void {
+    report.add(name, { { "producers", std::to_string(producers) } }, m);
+}
+
+int main(int argc, char** argv) {
+    bench::Report report;
+    auto push = [](auto& q, Item i) { q.push(i); };
+
+    add(report, "spsc", 1, throughput<Spsc>(1, push, drain<Spsc>));
+    for (int producers : { 1, 2, 4, 8, 16 }) {
+        add(report, "mpmc", producers, throughput<Mpmc>(producers, push, drain<Mpmc>));
+        add(report, "mutex_deque", producers, throughput<Mutex>(producers, push, drain_mutex));
+    }
+
+    auto pop = [](auto& q) { return q.pop().value; };
+    add(report, "spsc_round_trip", 1, round_trip<Spsc>(push, pop));
+    add(report, "mpmc_round_trip", 1, round_trip<Mpmc>(push, pop));
+    add(report, "mutex_round_trip", 1, round_trip<Mutex>(push, [](Mutex& q) {
+        Item next;
+        q.pop(next);
+        return next;
+    }));
+
+    if (auto path = bench::json_path(argc, argv)) {
+        if (auto out = std::fopen(path, "w")) {
+            report.write_json(out);
+            std::fclose(out);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "result.hpp"
+
+// Out-of-line error storage. Result<T, Boxed<E>> stores a single pointer in
+// place of E, so a large error struct no longer widens the Ok case. The
+// error is allocated only on the Err path, from a per-thread free list.
+
+namespace detail {
+
+// Fixed-size block pool per size class. Each thread allocates from and
+// releases to its own free list. A thread that releases more than it
+// allocates, e.g. the consumer of a pipeline, moves batches of blocks to a
+// shared list once its own holds cache_limit, and a thread whose list is
+// empty takes a batch from there before carving a new chunk. An exiting
+// thread hands all its blocks to the shared list. Boxes freed or made later
+// in its exit, e.g. by another thread_local's destructor, go straight to
+// the shared list. Chunks are never returned to the system.
+template<std::size_t Size, std::size_t Align>
+struct BoxPool {
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t block_align = Align < alignof(FreeBlock) ? alignof(FreeBlock) : Align;
+    static constexpr std::size_t block_size = ((Size < sizeof(FreeBlock) ? sizeof(FreeBlock) : Size) + block_align - 1) & ~(block_align - 1);
+    static constexpr std::size_t chunk_blocks = 64;
+    static constexpr std::size_t cache_limit = 2 * chunk_blocks;
+
+    // A null-terminated list of free blocks
+    struct Batch {
+        FreeBlock* head;
+        std::size_t count;
+    };
+
+    struct Shared {
+        std::mutex mutex;
+        std::vector<Batch> batches;
+
+        auto put(Batch batch) -> void {
+            std::lock_guard lock(mutex);
+            batches.push_back(batch);
+        }
+    };
+
+    // Trivially destructible, so it stays usable until the thread is gone.
+    // A limit of 0 marks it torn down: every block then passes through.
+    struct Cache {
+        FreeBlock* head = nullptr;
+        std::size_t count = 0;
+        std::size_t limit = cache_limit;
+    };
+
+    // Registered on the thread's first allocate or release
+    struct CacheFlush {
+        ~CacheFlush() {
+            auto& c = cache;
+            if (c.head != nullptr) {
+                shared().put({ c.head, c.count });
+            }
+            c.head = nullptr;
+            c.count = 0;
+            c.limit = 0;
+        }
+    };
+
+    // Never destroyed: threads may exit after static destructors have run
+    static auto shared() -> Shared& {
+        static auto s = new Shared;
+        return *s;
+    }
+
+    static inline thread_local Cache cache;
+    static inline thread_local CacheFlush flush;
+
+    static auto carve() -> Batch {
+        auto chunk = static_cast<std::byte*>(::operator new(block_size * chunk_blocks, std::align_val_t { block_align }));
+        Batch batch { nullptr, chunk_blocks };
+        for (std::size_t i = 0; i < chunk_blocks; ++i) {
+            auto block = reinterpret_cast<FreeBlock*>(chunk + i * block_size);
+            block->next = batch.head;
+            batch.head = block;
+        }
+        return batch;
+    }
+
+    [[gnu::noinline]] static auto refill(Cache& c) -> void {
+        if (c.limit == 0) {
+            // Torn down: take a single block
+            auto& s = shared();
+            std::lock_guard lock(s.mutex);
+            if (s.batches.empty()) {
+                s.batches.push_back(carve());
+            }
+            auto& batch = s.batches.back();
+            c.head = batch.head;
+            batch.head = batch.head->next;
+            if (--batch.count == 0) {
+                s.batches.pop_back();
+            }
+            c.head->next = nullptr;
+            c.count = 1;
+            return;
+        }
+
+        (void)&flush;
+        {
+            auto& s = shared();
+            std::lock_guard lock(s.mutex);
+            if (!s.batches.empty()) {
+                auto batch = s.batches.back();
+                s.batches.pop_back();
+                c.head = batch.head;
+                c.count = batch.count;
+                return;
+            }
+        }
+        auto batch = carve();
+        c.head = batch.head;
+        c.count = batch.count;
+    }
+
+    // Moves chunk_blocks blocks from the front of c to the shared list, or
+    // all of them once c is torn down
+    [[gnu::noinline]] static auto spill(Cache& c) -> void {
+        if (c.limit == 0) {
+            shared().put({ c.head, c.count });
+            c.head = nullptr;
+            c.count = 0;
+            return;
+        }
+        auto first = c.head;
+        auto last = first;
+        for (std::size_t i = 1; i < chunk_blocks; ++i) {
+            last = last->next;
+        }
+        c.head = last->next;
+        c.count -= chunk_blocks;
+        last->next = nullptr;
+        shared().put({ first, chunk_blocks });
+    }
+
+    static auto allocate() -> void* {
+        auto& c = cache;
+        if (c.head == nullptr) [[unlikely]] {
+            refill(c);
+        }
+        auto block = c.head;
+        c.head = block->next;
+        --c.count;
+        return block;
+    }
+
+    static auto release(void* p) -> void {
+        auto& c = cache;
+        if (c.head == nullptr) [[unlikely]] {
+            (void)&flush;
+        }
+        auto block = static_cast<FreeBlock*>(p);
+        block->next = c.head;
+        c.head = block;
+        if (++c.count > c.limit) [[unlikely]] {
+            spill(c);
+        }
+    }
+};
+
+} // namespace detail
+
+template<typename E>
+class Boxed {
+    using Pool = detail::BoxPool<sizeof(E), alignof(E)>;
+
+public:
+    Boxed() = default;
+
+    Boxed(E e) : ptr(make(std::move(e))) {}
+
+    Boxed(const Boxed& other) : ptr(other.ptr ? make(*other.ptr) : nullptr) {}
+
+    Boxed(Boxed&& other) noexcept : ptr(std::exchange(other.ptr, nullptr)) {}
+
+    auto operator=(Boxed other) noexcept -> Boxed& {
+        std::swap(ptr, other.ptr);
+        return *this;
+    }
+
+    ~Boxed() {
+        if (ptr != nullptr) {
+            ptr->~E();
+            Pool::release(ptr);
+        }
+    }
+
+    auto get() const -> const E& {
+        return *ptr;
+    }
+
+    auto operator*() const -> const E& {
+        return *ptr;
+    }
+
+    auto operator->() const -> const E* {
+        return ptr;
+    }
+
+    explicit operator bool() const {
+        return ptr != nullptr;
+    }
+
+private:
+    // Returns the block to the pool if E's constructor throws
+    template<typename A>
+    static auto make(A&& a) -> E* {
+        auto block = Pool::allocate();
+        if constexpr (std::is_nothrow_constructible_v<E, A>) {
+            return ::new (block) E(std::forward<A>(a));
+        } else {
+            try {
+                return ::new (block) E(std::forward<A>(a));
+            } catch (...) {
+                Pool::release(block);
+                throw;
+            }
+        }
+    }
+
+    E* ptr = nullptr;
+};
+
+template<typename E>
+struct Display<Boxed<E>> {
+    static void print(const Boxed<E>& e) {
+        Display<E>::print(*e);
+    }
+};
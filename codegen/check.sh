@@ -0,0 +1,85 @@
+#!/bin/sh
+# Compile codegen/snippets.cpp at -O2 and check each function's disassembly
+# against the ceilings in its `// codegen:` directive.
+#
+#   usage: codegen/check.sh [cxx] [outdir]
+set -eu
+
+CXX=${1:-c++}
+OUT=${2:-./out}
+SRC=$(dirname "$0")/snippets.cpp
+OBJ=$OUT/codegen_snippets.o
+ASM=$OUT/codegen_snippets.s
+
+mkdir -p "$OUT"
+$CXX -std=c++20 -O2 -fno-asynchronous-unwind-tables -I. -c "$SRC" -o "$OBJ"
+objdump -d --no-show-raw-insn "$OBJ" > "$ASM"
+
+# Print "<instructions> <calls>" for one function, alignment padding excluded
+count() {
+    awk -F'\t' -v fn="$1" '
+        $0 ~ "^[0-9a-f]+ <" fn ">:$" { inside = 1; next }
+        /^[0-9a-f]+ </ { inside = 0 }
+        inside && NF >= 2 && $1 ~ /^ *[0-9a-f]+:$/ {
+            split($2, words, " ")
+            op = words[1]
+            if (op ~ /^nop/ || op == "data16" || op == "cs" || $2 ~ /^xchg +%ax,%ax/) next
+            insns++
+            if (op ~ /^call/) calls++
+        }
+        END { printf "%d %d\n", insns, calls }
+    ' "$ASM"
+}
+
+# Print one function's instructions, sorted, with jump and call targets,
+# register names and alignment padding removed
+listing() {
+    awk -F'\t' -v fn="$1" '
+        $0 ~ "^[0-9a-f]+ <" fn ">:$" { inside = 1; next }
+        /^[0-9a-f]+ </ { inside = 0 }
+        inside && NF >= 2 && $1 ~ /^ *[0-9a-f]+:$/ {
+            split($2, words, " ")
+            op = words[1]
+            if (op ~ /^nop/ || op == "data16" || op == "cs" || $2 ~ /^xchg +%ax,%ax/) next
+            if (op ~ /^(j|call)/) print op
+            else print $2
+        }
+    ' "$ASM" | sed 's/  */ /g; s/%[a-z0-9]*/%r/g' | sort
+}
+
+failed=0
+directives=$(grep -o '// codegen: [a-z_0-9]* .*' "$SRC" | sed 's|// codegen: ||')
+while read -r fn limits; do
+    [ -n "$fn" ] || continue
+    max=$(echo "$limits" | sed -n 's/.*max=\([0-9]*\).*/\1/p')
+    set -- $(count "$fn")
+    insns=$1
+    calls=$2
+
+    status=ok
+    if [ "$insns" -eq 0 ]; then
+        status="FAIL (symbol not found)"
+    elif [ "$insns" -gt "$max" ]; then
+        status="FAIL (ceiling $max)"
+    fi
+    case "$limits" in
+        *no-call*) [ "$calls" -eq 0 ] || status="FAIL ($calls calls)" ;;
+    esac
+    same=$(echo "$limits" | sed -n 's/.*same-as=\([a-z_0-9]*\).*/\1/p')
+    if [ -n "$same" ] && [ "$status" = ok ] && [ "$(listing "$fn")" != "$(listing "$same")" ]; then
+        status="FAIL (differs from $same)"
+    fi
+
+    printf '%-20s %3d insns  %s\n' "$fn" "$insns" "$status"
+    case "$status" in
+        ok) ;;
+        *) failed=1 ;;
+    esac
+done <<DIRECTIVES
+$directives
+DIRECTIVES
+
+if [ "$failed" -ne 0 ]; then
+    echo "codegen regressed, see $ASM"
+    exit 1
+fi
@@ -0,0 +1,110 @@
+// Canonical hot Result operations whose machine code is pinned by check.sh.
+// Each function is preceded by a directive:
+//
+//   // codegen: <symbol> max=<instructions> [no-call] [same-as=<symbol>]
+//
+// same-as requires the same instructions as another snippet, compared as a
+// multiset so that scheduling, block order and register allocation may
+// differ; jump and call targets are ignored.
+// Raise a ceiling only when the extra instructions are understood.
+#include "error_code.hpp"
+#include "result.hpp"
+#include "sys.hpp"
+
+enum class CgError {
+    Null,
+    Negative,
+};
+
+enum class CgRootError {
+    Lookup,
+};
+
+enum class CgMirrorError {
+    Null,
+    Negative,
+};
+
+RESULT_ERROR_CATEGORY(CgError, 1, "codegen");
+
+template<>
+struct From<CgError, CgMirrorError> : FromTable<error_table<CgError, CgMirrorError>({
+    { CgError::Null, CgMirrorError::Null },
+    { CgError::Negative, CgMirrorError::Negative },
+})> {};
+
+template<>
+struct From<CgError, CgRootError> : FromTable<error_table<CgError, CgRootError>({
+    { CgError::Null, CgRootError::Lookup },
+    { CgError::Negative, CgRootError::Lookup },
+})> {};
+
+extern "C" {
+
+// codegen: cg_ok_or_ptr max=12 no-call
+auto cg_ok_or_ptr(int* p) -> Result<int*, CgError> {
+    return ok_or(p, CgError::Null);
+}
+
+// codegen: cg_map_int max=15 no-call
+auto cg_map_int(Result<int, CgError> r) -> Result<int, CgError> {
+    return r.map([] (int i) { return i + 1; });
+}
+
+// codegen: cg_unwrap_or max=7 no-call
+auto cg_unwrap_or(Result<int, CgError> r) -> int {
+    return unwrap_or(r, -1);
+}
+
+// codegen: cg_match max=8 no-call
+auto cg_match(Result<int, CgError> r) -> int {
+    return match(
+        r,
+        [] (int i) { return i; },
+        [] (CgError e) { return -static_cast<int>(e); }
+    );
+}
+
+// codegen: cg_chain max=17 no-call
+auto cg_chain(int* p) -> Result<int, CgRootError> {
+    return ok_or(p, CgError::Null)
+        .map([] (int* q) { return *q; })
+        .and_then([] (int i) {
+            return i < 0 ? err<int, CgError>(CgError::Negative) : ok<int, CgError>(i);
+        })
+        .map_err([] (CgError) { return CgRootError::Lookup; });
+}
+
+
+// codegen: cg_into_code max=13 no-call
+auto cg_into_code(Result<int, CgError> r) -> Result<int, ErrorCode> {
+    return into_code(r);
+}
+
+
+// codegen: cg_from_identity max=12 no-call
+auto cg_from_identity(Result<int, CgError> r) -> Result<int, CgMirrorError> {
+    return r;
+}
+
+// codegen: cg_from_table max=17 no-call
+auto cg_from_table(Result<int, CgError> r) -> Result<int, CgRootError> {
+    return r;
+}
+
+// The check sys::read replaces, written out by hand
+// codegen: cg_read_manual max=14
+auto cg_read_manual(int fd, void* buf, std::size_t n) -> Result<ssize_t, sys::Errno> {
+    auto r = ::read(fd, buf, n);
+    if (r == -1) [[unlikely]] {
+        return err<ssize_t, sys::Errno>(sys::Errno { errno });
+    }
+    return ok<ssize_t, sys::Errno>(r);
+}
+
+// codegen: cg_read_wrapped max=14 same-as=cg_read_manual
+auto cg_read_wrapped(int fd, void* buf, std::size_t n) -> Result<ssize_t, sys::Errno> {
+    return sys::read(fd, buf, n);
+}
+
+}
@@ -0,0 +1,220 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <source_location>
+#include <type_traits>
+#include <utility>
+#include "result.hpp"
+
+// Error context chains. Chain<E> is an error E plus a link to the frames that
+// led to it: the errors it was converted from, where that happened and an
+// optional message. Frames are bump-allocated in a per-thread ErrorArena, so
+// adding one is O(1) without malloc, and released in bulk by ArenaScope.
+//
+// A Chain must not outlive the scope whose arena holds its frames.
+
+class ErrorArena {
+public:
+    struct Mark {
+        void* chunk;
+        std::size_t used;
+    };
+
+    ErrorArena() = default;
+    ErrorArena(const ErrorArena&) = delete;
+    auto operator=(const ErrorArena&) -> ErrorArena& = delete;
+
+    ~ErrorArena() {
+        auto chunk = head;
+        while (chunk != nullptr) {
+            auto next = chunk->next;
+            ::operator delete(chunk);
+            chunk = next;
+        }
+    }
+
+    // The calling thread's arena
+    static auto current() -> ErrorArena& {
+        static thread_local ErrorArena arena;
+        return arena;
+    }
+
+    auto allocate(std::size_t size, std::size_t align) -> void* {
+        auto offset = (used + align - 1) & ~(align - 1);
+        if (active == nullptr || offset + size > active->capacity) {
+            next_chunk(size + align);
+            offset = 0;
+        }
+        used = offset + size;
+        return active->data() + offset;
+    }
+
+    auto mark() const -> Mark {
+        return Mark { active, used };
+    }
+
+    // Release everything allocated since `m`, chunks are kept for reuse
+    auto rewind(Mark m) -> void {
+        active = static_cast<Chunk*>(m.chunk);
+        used = m.used;
+    }
+
+    auto reset() -> void {
+        rewind({ nullptr, 0 });
+    }
+
+private:
+    static constexpr std::size_t chunk_size = 16 * 1024;
+
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* next;
+        std::size_t capacity;
+
+        auto data() -> std::byte* {
+            return reinterpret_cast<std::byte*>(this + 1);
+        }
+    };
+
+    [[gnu::noinline]] auto next_chunk(std::size_t min_size) -> void {
+        auto next = active == nullptr ? head : active->next;
+        if (next == nullptr || next->capacity < min_size) {
+            auto capacity = min_size > chunk_size ? min_size : chunk_size;
+            auto chunk = ::new (::operator new(sizeof(Chunk) + capacity)) Chunk { next, capacity };
+            if (active == nullptr) {
+                head = chunk;
+            } else {
+                active->next = chunk;
+            }
+            next = chunk;
+        }
+        active = next;
+    }
+
+    Chunk* head = nullptr;
+    Chunk* active = nullptr;
+    std::size_t used = 0;
+};
+
+// Releases the frames allocated on this thread while the scope was alive,
+// e.g. one scope per request
+class ArenaScope {
+public:
+    ArenaScope() : mark(ErrorArena::current().mark()) {}
+    ArenaScope(const ArenaScope&) = delete;
+    auto operator=(const ArenaScope&) -> ArenaScope& = delete;
+
+    ~ArenaScope() {
+        ErrorArena::current().rewind(mark);
+    }
+
+private:
+    ErrorArena::Mark mark;
+};
+
+namespace detail {
+
+struct ContextFrame {
+    const ContextFrame* next;
+    void (*print)(const void*);
+    const void* error;
+    const char* message;
+    std::source_location loc;
+};
+
+template<typename E>
+auto push_frame(const ContextFrame* next, const E* error, const char* message, std::source_location loc) -> const ContextFrame* {
+    auto& arena = ErrorArena::current();
+    const void* stored = nullptr;
+    void (*print)(const void*) = nullptr;
+    if constexpr (!std::is_void_v<E>) {
+        static_assert(std::is_trivially_destructible_v<E>, "Chain: causes are released in bulk and must be trivially destructible");
+        stored = ::new (arena.allocate(sizeof(E), alignof(E))) E(*error);
+        print = [] (const void* p) { Display<E>::print(*static_cast<const E*>(p)); };
+    }
+
+    return ::new (arena.allocate(sizeof(ContextFrame), alignof(ContextFrame))) ContextFrame { next, print, stored, message, loc };
+}
+
+} // namespace detail
+
+template<typename E>
+struct Chain {
+    E error;
+    const detail::ContextFrame* cause = nullptr;
+
+    Chain() = default;
+    Chain(E e, const detail::ContextFrame* c = nullptr) : error(e), cause(c) {}
+
+    // Visit the frames, most recent first
+    template<typename F>
+    auto for_each_frame(F&& f) const -> void {
+        for (auto frame = cause; frame != nullptr; frame = frame->next) {
+            f(*frame);
+        }
+    }
+};
+
+template<typename E>
+struct Display<Chain<E>> {
+    static void print(const Chain<E>& e) {
+        Display<E>::print(e.error);
+        e.for_each_frame([] (const detail::ContextFrame& frame) {
+            if (frame.message != nullptr) {
+                std::fprintf(stderr, "  context: %s\n", frame.message);
+            }
+            if (frame.print != nullptr) {
+                std::fputs("  caused by: ", stderr);
+                std::fflush(stderr);
+                frame.print(frame.error);
+            }
+            std::fprintf(stderr, "    at %s:%u in %s\n", frame.loc.file_name(), static_cast<unsigned>(frame.loc.line()), frame.loc.function_name());
+        });
+    }
+};
+
+namespace detail {
+
+template<typename E>
+struct ChainTraits {
+    using root = E;
+
+    static auto cause(const E&) -> const ContextFrame* { return nullptr; }
+    static auto error(const E& e) -> const E& { return e; }
+};
+
+template<typename E>
+struct ChainTraits<Chain<E>> {
+    using root = E;
+
+    static auto cause(const Chain<E>& c) -> const ContextFrame* { return c.cause; }
+    static auto error(const Chain<E>& c) -> const E& { return c.error; }
+};
+
+} // namespace detail
+
+// Convert the error with f and keep the previous error as the cause, like
+// map_err without losing where the error came from
+template<typename T, typename E, typename F>
+auto wrap_err(const Result<T, E>& res, F f, const char* message = nullptr, std::source_location loc = std::source_location::current())
+    -> Result<T, Chain<decltype(f(detail::ChainTraits<E>::error(std::declval<E>())))>> {
+    using Root = typename detail::ChainTraits<E>::root;
+    using Target = decltype(f(std::declval<Root>()));
+    static_assert(std::is_invocable_v<F, Root>, "wrap_err: F must be callable with the error");
+
+    return res.map_err([&] (const E& e) {
+        auto& root = detail::ChainTraits<E>::error(e);
+        return Chain<Target>(f(root), detail::push_frame(detail::ChainTraits<E>::cause(e), &root, message, loc));
+    });
+}
+
+// Attach a message to the error, keeping its type
+template<typename T, typename E>
+auto context(const Result<T, E>& res, const char* message, std::source_location loc = std::source_location::current())
+    -> Result<T, Chain<typename detail::ChainTraits<E>::root>> {
+    using Root = typename detail::ChainTraits<E>::root;
+
+    return res.map_err([&] (const E& e) {
+        return Chain<Root>(detail::ChainTraits<E>::error(e), detail::push_frame<void>(detail::ChainTraits<E>::cause(e), nullptr, message, loc));
+    });
+}
@@ -0,0 +1,198 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "boxed.hpp"
+#include "result.hpp"
+
+// Type-erased error for boundaries where templating on E is not an option,
+// e.g. plugin interfaces. DynError holds any error type with a Display in a
+// 24 byte inline buffer next to a vtable pointer; larger payloads go to the
+// Boxed<E> block pool. Downcasting compares per-type keys, so no RTTI is
+// needed. Types are identified by the address of a function-local static,
+// so shared libraries must export these symbols (default visibility).
+
+namespace detail {
+
+template<typename E>
+auto dyn_type_key() -> const void* {
+    // Not const: constant merging or identical code folding could give
+    // two types the same const key
+    static char key;
+    return &key;
+}
+
+struct DynErrorVTable {
+    const void* (*type)();
+    void (*print)(const void* storage);
+    void (*copy)(void* dst, const void* src);
+    void (*relocate)(void* dst, void* src);
+    void (*destroy)(void* storage);
+    const void* (*get)(const void* storage);
+    bool trivial;
+};
+
+inline constexpr std::size_t dyn_inline_size = 24;
+
+template<typename E>
+inline constexpr bool dyn_inline = sizeof(E) <= dyn_inline_size
+    && alignof(E) <= alignof(void*)
+    && std::is_nothrow_move_constructible_v<E>;
+
+template<typename E>
+struct DynStorage {
+    using Pool = BoxPool<sizeof(E), alignof(E)>;
+
+    static auto get(const void* s) -> const E* {
+        if constexpr (dyn_inline<E>) {
+            return std::launder(static_cast<const E*>(s));
+        } else {
+            return *static_cast<E* const*>(s);
+        }
+    }
+
+    static auto create(void* s, const E& e) -> void {
+        if constexpr (dyn_inline<E>) {
+            ::new (s) E(e);
+        } else {
+            *static_cast<E**>(s) = ::new (Pool::allocate()) E(e);
+        }
+    }
+
+    static auto destroy(void* s) -> void {
+        if constexpr (dyn_inline<E>) {
+            std::launder(static_cast<E*>(s))->~E();
+        } else {
+            auto p = *static_cast<E**>(s);
+            p->~E();
+            Pool::release(p);
+        }
+    }
+
+    static auto relocate(void* dst, void* src) -> void {
+        if constexpr (dyn_inline<E>) {
+            auto from = std::launder(static_cast<E*>(src));
+            ::new (dst) E(std::move(*from));
+            from->~E();
+        } else {
+            *static_cast<E**>(dst) = *static_cast<E**>(src);
+        }
+    }
+
+    static constexpr DynErrorVTable vtable {
+        &dyn_type_key<E>,
+        [] (const void* s) { Display<E>::print(*get(s)); },
+        [] (void* dst, const void* src) { create(dst, *get(src)); },
+        &relocate,
+        &destroy,
+        [] (const void* s) -> const void* { return get(s); },
+        dyn_inline<E> && std::is_trivially_copyable_v<E>,
+    };
+};
+
+} // namespace detail
+
+class DynError {
+public:
+    DynError() = default;
+
+    template<typename E>
+    requires (!std::same_as<std::remove_cvref_t<E>, DynError>)
+    DynError(const E& e) : vtable(&detail::DynStorage<E>::vtable) {
+        detail::DynStorage<E>::create(storage, e);
+    }
+
+    DynError(const DynError& other) : vtable(other.vtable) {
+        if (vtable == nullptr) {
+            return;
+        }
+        if (vtable->trivial) {
+            std::memcpy(storage, other.storage, sizeof(storage));
+        } else {
+            vtable->copy(storage, other.storage);
+        }
+    }
+
+    DynError(DynError&& other) noexcept : vtable(std::exchange(other.vtable, nullptr)) {
+        if (vtable == nullptr) {
+            return;
+        }
+        if (vtable->trivial) {
+            std::memcpy(storage, other.storage, sizeof(storage));
+        } else {
+            vtable->relocate(storage, other.storage);
+        }
+    }
+
+    auto operator=(const DynError& other) -> DynError& {
+        if (this != &other) {
+            reset();
+            ::new (this) DynError(other);
+        }
+        return *this;
+    }
+
+    auto operator=(DynError&& other) noexcept -> DynError& {
+        if (this != &other) {
+            reset();
+            ::new (this) DynError(std::move(other));
+        }
+        return *this;
+    }
+
+    ~DynError() {
+        reset();
+    }
+
+    // True if this holds an E
+    template<typename E>
+    auto is() const -> bool {
+        return vtable != nullptr && vtable->type() == detail::dyn_type_key<E>();
+    }
+
+    // The held E, or nullptr if this holds another type
+    template<typename E>
+    auto downcast() const -> const E* {
+        return is<E>() ? static_cast<const E*>(vtable->get(storage)) : nullptr;
+    }
+
+    auto empty() const -> bool {
+        return vtable == nullptr;
+    }
+
+    auto print() const -> void {
+        if (vtable != nullptr) {
+            vtable->print(storage);
+        }
+    }
+
+private:
+    auto reset() -> void {
+        if (vtable != nullptr && !vtable->trivial) {
+            vtable->destroy(storage);
+        }
+        vtable = nullptr;
+    }
+
+    alignas(void*) std::byte storage[detail::dyn_inline_size];
+    const detail::DynErrorVTable* vtable = nullptr;
+};
+
+template<>
+struct Display<DynError> {
+    static void print(const DynError& e) {
+        e.print();
+    }
+};
+
+// Any Result<T, E> converts implicitly into Result<T, DynError>
+template<typename E>
+requires (!std::same_as<E, DynError>)
+struct From<E, DynError> {
+    static auto convert(const E& e) -> DynError {
+        return DynError(e);
+    }
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+#include "result.hpp"
+
+// Packed 64-bit error codes. One ErrorCode carries the category of the
+// originating error enum, its value and a small payload (an errno, an index),
+// so errors from every subsystem share one trivially copyable type and
+// Result<T, ErrorCode> travels in registers.
+//
+//   bits 63..48  category  (registered per error enum)
+//   bits 47..32  code      (the enum value)
+//   bits 31..0   payload
+//
+// Register an enum once, next to its Display:
+//
+//   RESULT_ERROR_CATEGORY(ParseError, 3, "parse");
+//
+// Two enums registered with the same id fail to compile when they meet in
+// one TU, and abort at start-up otherwise. Enum values outside 0..65535 do
+// not fit the code field: converting one fails constant evaluation and
+// traps at run time.
+
+// Specialized by RESULT_ERROR_CATEGORY for every registered enum
+template<typename E>
+struct ErrorCategory;
+
+namespace detail {
+
+template<typename E>
+concept RegisteredError = std::is_enum_v<E> && requires {
+    { ErrorCategory<E>::id } -> std::convertible_to<std::uint16_t>;
+};
+
+// Specialized by RESULT_ERROR_CATEGORY for every id in use, so a second
+// enum with the same id is a redefinition
+template<std::uint16_t Id>
+struct CategoryOwner;
+
+// Not constexpr: reaching it fails constant evaluation. At run time it
+// traps, like error_table_invalid.
+[[noreturn]] inline auto error_code_invalid() -> void {
+    __builtin_trap();
+}
+
+// The enum value as a code field
+template<typename E>
+constexpr auto category_code(E e) -> std::uint16_t {
+    auto v = static_cast<std::underlying_type_t<E>>(e);
+    if ((std::is_signed_v<decltype(v)> && v < 0) || static_cast<std::uintmax_t>(v) > 0xffff) [[unlikely]] {
+        error_code_invalid();
+    }
+    return static_cast<std::uint16_t>(v);
+}
+
+struct CategoryEntry {
+    std::uint16_t id;
+    const char* name;
+    void (*print)(std::uint16_t code);
+};
+
+// Only Display looks categories up, so a short list scanned in order does
+inline constexpr std::size_t max_categories = 256;
+
+struct CategoryTable {
+    CategoryEntry entries[max_categories];
+    std::size_t count;
+};
+
+inline auto category_table() -> CategoryTable& {
+    static CategoryTable table;
+    return table;
+}
+
+inline auto find_category(std::uint16_t id) -> const CategoryEntry* {
+    auto& table = category_table();
+    for (std::size_t i = 0; i < table.count; ++i) {
+        if (table.entries[i].id == id) {
+            return &table.entries[i];
+        }
+    }
+    return nullptr;
+}
+
+template<typename E>
+auto print_category(std::uint16_t code) -> void {
+    Display<E>::print(static_cast<E>(code));
+}
+
+// Runs during static initialization, once per registered enum
+template<typename E>
+auto register_category() -> bool {
+    auto id = ErrorCategory<E>::id;
+    if (auto entry = find_category(id)) {
+        if (entry->print != &print_category<E>) {
+            std::fprintf(stderr, "RESULT_ERROR_CATEGORY: id %u is used by \"%s\" and \"%s\"\n", id, entry->name, ErrorCategory<E>::name);
+            std::abort();
+        }
+        return true;
+    }
+
+    auto& table = category_table();
+    if (table.count == max_categories) {
+        std::fprintf(stderr, "RESULT_ERROR_CATEGORY: more than %zu categories\n", max_categories);
+        std::abort();
+    }
+    table.entries[table.count++] = CategoryEntry { id, ErrorCategory<E>::name, &print_category<E> };
+    return true;
+}
+
+} // namespace detail
+
+class ErrorCode {
+public:
+    constexpr ErrorCode() = default;
+
+    constexpr ErrorCode(std::uint16_t category, std::uint16_t code, std::uint32_t payload = 0)
+        : bits(static_cast<std::uint64_t>(category) << 48 | static_cast<std::uint64_t>(code) << 32 | payload) {}
+
+    // Any registered error enum converts implicitly
+    template<detail::RegisteredError E>
+    constexpr ErrorCode(E e, std::uint32_t payload = 0)
+        : ErrorCode(ErrorCategory<E>::id, detail::category_code(e), payload) {}
+
+    static constexpr auto from_bits(std::uint64_t bits) -> ErrorCode {
+        ErrorCode e;
+        e.bits = bits;
+        return e;
+    }
+
+    constexpr auto category() const -> std::uint16_t { return static_cast<std::uint16_t>(bits >> 48); }
+    constexpr auto code() const -> std::uint16_t { return static_cast<std::uint16_t>(bits >> 32); }
+    constexpr auto payload() const -> std::uint32_t { return static_cast<std::uint32_t>(bits); }
+    constexpr auto raw() const -> std::uint64_t { return bits; }
+
+    constexpr auto with_payload(std::uint32_t payload) const -> ErrorCode {
+        return ErrorCode(category(), code(), payload);
+    }
+
+    // True if this code came from enum E
+    template<detail::RegisteredError E>
+    constexpr auto is() const -> bool {
+        return category() == ErrorCategory<E>::id;
+    }
+
+    // The original enum value, check is<E>() first
+    template<detail::RegisteredError E>
+    constexpr auto as() const -> E {
+        return static_cast<E>(code());
+    }
+
+    // Compares category and code, ignoring the payload
+    template<detail::RegisteredError E>
+    constexpr auto operator==(E e) const -> bool {
+        return is<E>() && as<E>() == e;
+    }
+
+    constexpr auto operator==(const ErrorCode&) const -> bool = default;
+
+private:
+    std::uint64_t bits = 0;
+};
+
+static_assert(sizeof(ErrorCode) == sizeof(std::uint64_t));
+static_assert(std::is_trivially_copyable_v<ErrorCode>);
+
+#define RESULT_ERROR_CATEGORY(Enum, Id, Name)                                           \
+    template<>                                                                          \
+    struct ErrorCategory<Enum> {                                                        \
+        static_assert(std::is_enum_v<Enum>, "RESULT_ERROR_CATEGORY: " #Enum " must be an enum"); \
+        static constexpr std::uint16_t id = (Id);                                       \
+        static constexpr const char* name = (Name);                                     \
+        static inline const bool registered = detail::register_category<Enum>();        \
+    };                                                                                  \
+    template<>                                                                          \
+    struct detail::CategoryOwner<(Id)> {                                                \
+        using type = Enum;                                                              \
+    }
+
+template<>
+struct Display<ErrorCode> {
+    static void print(ErrorCode e) {
+        auto entry = detail::find_category(e.category());
+        if (entry == nullptr) {
+            std::fprintf(stderr, "error %u:%u (payload %u)\n", e.category(), e.code(), e.payload());
+            return;
+        }
+
+        std::fprintf(stderr, "[%s] ", entry->name);
+        std::fflush(stderr);
+        entry->print(e.code());
+        if (e.payload() != 0) {
+            std::fprintf(stderr, "  payload: %u\n", e.payload());
+        }
+    }
+};
+
+// Result<T, E> converts implicitly into Result<T, ErrorCode>
+template<detail::RegisteredError E>
+struct From<E, ErrorCode> {
+    static constexpr auto convert(E e) -> ErrorCode {
+        return ErrorCode(e);
+    }
+};
+
+// Convert the error of any Result over a registered enum into an ErrorCode
+template<typename T, detail::RegisteredError E>
+auto into_code(const Result<T, E>& res, std::uint32_t payload = 0) -> Result<T, ErrorCode> {
+    return res.map_err([payload] (E e) { return ErrorCode(e, payload); });
+}
@@ -0,0 +1,357 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "coarse_clock.hpp"
+#include "result.hpp"
+
+// Asynchronous error reporting. report(e) stores a compact record (type, enum
+// value, timestamp) in a lock-free ring owned by the calling thread, and a
+// background thread formats the records with Display<E>::print. Threads
+// that report errors never touch stderr's lock or make a syscall.
+//
+// In SinkMode::Dedup a thread records an error only if it has not reported
+// the same value within `window`. Repeats inside the window only bump a
+// counter. Once the window has ended, or another error takes its table
+// slot, the count is published as a RecordKind::Suppressed record; the
+// drain publishes counts of ended windows, and the destructor all of them.
+// An error storm then costs a table lookup per error.
+//
+//   ErrorSink sink({ .mode = SinkMode::Dedup });
+//   if (r.tag == Result<Row, LoadError>::Tag::Err) {
+//       sink.report(r.error);
+//   }
+//
+// A full ring drops the record and counts it in dropped() instead of
+// blocking. Timestamps come from the coarse monotonic clock as last read by
+// the drain thread, so their resolution is the drain interval; a sink
+// without a drain thread reads the clock on every report.
+
+enum class SinkMode : std::uint8_t {
+    All,   // every error is recorded
+    Dedup, // at most one record per error value per thread and window
+};
+
+namespace detail {
+
+inline constexpr std::uint32_t max_sink_types = 256;
+
+inline std::atomic<std::uint32_t> sink_type_count { 0 };
+inline void (*sink_printers[max_sink_types])(std::int64_t);
+
+// Registers E the first time it is reported. The printer is stored before
+// any record of type E is published, so the drain thread always sees it.
+template<typename E>
+auto sink_type_id() -> std::uint32_t {
+    static const std::uint32_t id = [] {
+        auto id = sink_type_count.fetch_add(1, std::memory_order_relaxed);
+        if (id >= max_sink_types) {
+            std::fputs("ErrorSink: too many error types\n", stderr);
+            std::abort();
+        }
+        sink_printers[id] = [](std::int64_t value) {
+            Display<E>::print(static_cast<E>(value));
+        };
+        return id;
+    }();
+    return id;
+}
+
+inline std::atomic<std::uint64_t> next_sink_id { 1 };
+
+} // namespace detail
+
+enum class RecordKind : std::uint8_t {
+    Error,      // one report
+    Suppressed, // `repeats` further reports of the error in one Dedup window
+};
+
+struct ErrorRecord {
+    std::uint16_t type;
+    RecordKind kind;
+    std::uint32_t repeats; // Suppressed only
+    std::int64_t value;
+    std::uint64_t time_ns; // coarse monotonic clock, see ErrorSink
+
+    template<typename E>
+    auto is() const -> bool {
+        return type == detail::sink_type_id<E>();
+    }
+
+    template<typename E>
+    auto as() const -> E {
+        return static_cast<E>(value);
+    }
+};
+
+class ErrorSink {
+public:
+    struct Options {
+        SinkMode mode = SinkMode::All;
+        std::chrono::milliseconds window { 1000 };  // Dedup window
+        std::chrono::milliseconds interval { 10 };  // between background drains, 0 for none
+        std::size_t ring_size = 1024;              // records per thread, rounded up to a power of two
+    };
+
+    ErrorSink() : ErrorSink(Options {}) {}
+
+    explicit ErrorSink(Options options)
+        : options(options), start_ns(detail::coarse_now_ns()), clock_ns(start_ns),
+          window_ns(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(options.window).count())),
+          id(detail::next_sink_id.fetch_add(1, std::memory_order_relaxed)) {
+        ring_mask = 1;
+        while (ring_mask < options.ring_size) {
+            ring_mask *= 2;
+        }
+        ring_mask -= 1;
+        if (options.interval.count() != 0) {
+            drainer = std::thread([this] { run(); });
+        }
+    }
+
+    ErrorSink(const ErrorSink&) = delete;
+    auto operator=(const ErrorSink&) -> ErrorSink& = delete;
+
+    // Stops the background thread and prints what is still queued,
+    // including the counts of Dedup windows that have not ended
+    ~ErrorSink() {
+        if (drainer.joinable()) {
+            {
+                std::lock_guard lock(wake_mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            drainer.join();
+        }
+        collect([this](const ErrorRecord& r) { print(r); }, true);
+    }
+
+    template<typename E>
+    auto report(E e) -> void {
+        static_assert(std::is_enum_v<E>, "ErrorSink::report: E must be an enum type");
+        auto type = static_cast<std::uint16_t>(detail::sink_type_id<E>());
+        auto value = static_cast<std::int64_t>(e);
+        auto& ring = thread_ring();
+        auto now = options.interval.count() != 0 ? clock_ns.load(std::memory_order_relaxed) : detail::coarse_now_ns();
+        if (options.mode == SinkMode::Dedup) {
+            auto& seen = ring.seen[static_cast<std::size_t>(static_cast<std::uint64_t>(value) * 31 + type) & (ThreadRing::seen_size - 1)];
+            auto repeats = seen.repeats.load(std::memory_order_relaxed);
+            if (seen.type.load(std::memory_order_relaxed) == type && seen.value.load(std::memory_order_relaxed) == value
+                && now - seen.since_ns.load(std::memory_order_relaxed) < window_ns) [[likely]] {
+                seen.repeats.store(repeats + 1, std::memory_order_relaxed);
+                return;
+            }
+            reuse(ring, seen, type, value, now);
+        }
+        push(ring, ErrorRecord { type, RecordKind::Error, 0, value, now });
+    }
+
+    // Calls on_record for every queued record, oldest first per thread,
+    // then for the suppressed counts of Dedup windows that have ended, and
+    // returns their number
+    template<typename F>
+    auto drain(F&& on_record) -> std::size_t {
+        return collect(on_record, false);
+    }
+
+    // Prints the queued records to stderr
+    auto drain() -> std::size_t {
+        return drain([this](const ErrorRecord& r) { print(r); });
+    }
+
+    // Records lost to full rings
+    auto dropped() const -> std::uint64_t {
+        return lost.load(std::memory_order_relaxed);
+    }
+
+private:
+    // A Dedup table slot. Only the ring's thread writes the fields, so it
+    // counts repeats without atomic read-modify-writes. `published` is the
+    // slot's epoch in the high half and, in the low half, how many of
+    // `repeats` the drain has published. The thread starts a new epoch when
+    // it reuses the slot, which fails a drain that read the old fields.
+    struct Seen {
+        static constexpr std::uint64_t count_mask = 0xffffffff;
+        static constexpr std::uint64_t busy = count_mask; // fields changing
+        static constexpr std::uint64_t next_epoch = count_mask + 1;
+
+        std::atomic<std::uint16_t> type { 0xffff };
+        std::atomic<std::uint32_t> repeats { 0 };
+        std::atomic<std::int64_t> value { 0 };
+        std::atomic<std::uint64_t> since_ns { 0 };
+        std::atomic<std::uint64_t> published { 0 };
+    };
+
+    // One producer (its thread), one consumer (the drain)
+    struct ThreadRing {
+        static constexpr std::size_t seen_size = 64;
+
+        explicit ThreadRing(std::size_t size, std::thread::id owner)
+            : owner(owner), records(std::make_unique<ErrorRecord[]>(size)) {}
+
+        std::thread::id owner;
+        std::unique_ptr<ErrorRecord[]> records;
+        alignas(64) std::atomic<std::size_t> head { 0 };
+        alignas(64) std::atomic<std::size_t> tail { 0 };
+        Seen seen[seen_size];
+    };
+
+    // The slot's window ended or another error takes it: publishes the
+    // repeats the drain has not, then starts the slot over
+    [[gnu::noinline]] auto reuse(ThreadRing& ring, Seen& seen, std::uint16_t type, std::int64_t value, std::uint64_t now) -> void {
+        auto epoch = seen.published.load(std::memory_order_relaxed) & ~Seen::count_mask;
+        auto done = static_cast<std::uint32_t>(seen.published.exchange(epoch | Seen::busy, std::memory_order_acq_rel));
+        auto rest = seen.repeats.load(std::memory_order_relaxed) - done;
+        if (rest != 0) {
+            push(ring, ErrorRecord { seen.type.load(std::memory_order_relaxed), RecordKind::Suppressed, rest,
+                                     seen.value.load(std::memory_order_relaxed), now });
+        }
+        seen.type.store(type, std::memory_order_relaxed);
+        seen.value.store(value, std::memory_order_relaxed);
+        seen.since_ns.store(now, std::memory_order_relaxed);
+        seen.repeats.store(0, std::memory_order_relaxed);
+        seen.published.store(epoch + Seen::next_epoch, std::memory_order_release);
+    }
+
+    // drain(f); flush_all also publishes the counts of windows still open
+    template<typename F>
+    auto collect(F&& on_record, bool flush_all) -> std::size_t {
+        std::lock_guard drain_lock(drain_mutex);
+        std::vector<ThreadRing*> snapshot;
+        {
+            std::lock_guard lock(rings_mutex);
+            for (auto& r : rings) {
+                snapshot.push_back(r.get());
+            }
+        }
+        std::size_t n = 0;
+        for (auto ring : snapshot) {
+            auto head = ring->head.load(std::memory_order_relaxed);
+            auto tail = ring->tail.load(std::memory_order_acquire);
+            for (; head != tail; ++head, ++n) {
+                on_record(ring->records[head & ring_mask]);
+            }
+            ring->head.store(head, std::memory_order_release);
+
+            if (options.mode == SinkMode::Dedup) {
+                auto now = detail::coarse_now_ns();
+                for (auto& seen : ring->seen) {
+                    auto state = seen.published.load(std::memory_order_acquire);
+                    auto done = static_cast<std::uint32_t>(state);
+                    auto repeats = seen.repeats.load(std::memory_order_relaxed);
+                    if (done == Seen::busy || repeats == done
+                        || (!flush_all && now - seen.since_ns.load(std::memory_order_relaxed) < window_ns)) {
+                        continue;
+                    }
+                    ErrorRecord record { seen.type.load(std::memory_order_relaxed), RecordKind::Suppressed, repeats - done,
+                                         seen.value.load(std::memory_order_relaxed), now };
+                    if (seen.published.compare_exchange_strong(state, (state & ~Seen::count_mask) | repeats, std::memory_order_acq_rel)) {
+                        on_record(record);
+                        ++n;
+                    }
+                }
+            }
+        }
+        return n;
+    }
+
+    // The rings of the last few sinks a thread reported to. Sink ids are
+    // never reused, so entries of destroyed sinks only age out.
+    struct RingCache {
+        static constexpr std::size_t size = 4;
+
+        std::uint64_t sink[size] = {};
+        ThreadRing* ring[size] = {};
+        std::size_t next = 0; // replaced on the next miss
+    };
+
+    // The calling thread's ring. A thread that switches between a few sinks
+    // finds their rings in its cache and stays off rings_mutex.
+    auto thread_ring() -> ThreadRing& {
+        thread_local RingCache cache;
+        for (std::size_t i = 0; i < RingCache::size; ++i) {
+            if (cache.sink[i] == id) [[likely]] {
+                return *cache.ring[i];
+            }
+        }
+        auto slot = cache.next;
+        cache.next = (slot + 1) % RingCache::size;
+        cache.sink[slot] = id;
+        cache.ring[slot] = find_ring();
+        return *cache.ring[slot];
+    }
+
+    // Thread ids are reused only after the old thread has exited, so a new
+    // thread with the same id may take over its ring
+    [[gnu::noinline]] auto find_ring() -> ThreadRing* {
+        std::lock_guard lock(rings_mutex);
+        auto self = std::this_thread::get_id();
+        for (auto& r : rings) {
+            if (r->owner == self) {
+                return r.get();
+            }
+        }
+        rings.push_back(std::make_unique<ThreadRing>(ring_mask + 1, self));
+        return rings.back().get();
+    }
+
+    auto push(ThreadRing& ring, const ErrorRecord& record) -> void {
+        auto tail = ring.tail.load(std::memory_order_relaxed);
+        if (tail - ring.head.load(std::memory_order_acquire) > ring_mask) [[unlikely]] {
+            lost.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring.records[tail & ring_mask] = record;
+        ring.tail.store(tail + 1, std::memory_order_release);
+    }
+
+    auto print(const ErrorRecord& r) const -> void {
+        std::fprintf(stderr, "[%.3fs] ", static_cast<double>(r.time_ns - start_ns) / 1e9);
+        if (r.kind == RecordKind::Suppressed) {
+            std::fprintf(stderr, "(%u more suppressed) ", r.repeats);
+        }
+        detail::sink_printers[r.type](r.value);
+    }
+
+    auto run() -> void {
+        std::unique_lock lock(wake_mutex);
+        while (!stopping) {
+            wake.wait_for(lock, options.interval);
+            lock.unlock();
+            clock_ns.store(detail::coarse_now_ns(), std::memory_order_relaxed);
+            drain();
+            if (auto total = lost.load(std::memory_order_relaxed); total != lost_printed) {
+                std::fprintf(stderr, "ErrorSink: %llu records dropped\n", static_cast<unsigned long long>(total - lost_printed));
+                lost_printed = total;
+            }
+            lock.lock();
+        }
+    }
+
+    Options options;
+    std::uint64_t start_ns;
+    std::atomic<std::uint64_t> clock_ns; // advanced by the drain thread
+    std::uint64_t window_ns;
+    std::size_t ring_mask;
+    std::uint64_t id; // distinguishes sinks in the per-thread cache
+    std::atomic<std::uint64_t> lost { 0 };
+    std::uint64_t lost_printed = 0; // drain thread only
+
+    std::mutex rings_mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::mutex drain_mutex;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread drainer;
+};
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <string>
 #include "result.hpp"
+#include "context.hpp"
+#include "parse.hpp"
 
 enum class RootError {
     Hello, 
@@ -30,46 +32,30 @@ struct Display<NestedError> {
 };
 
 
+// Declares how a NestedError becomes a RootError, once for every call site
+template<>
+struct From<NestedError, RootError> : FromTable<error_table<NestedError, RootError>({
+    { NestedError::World, RootError::Hello },
+})> {};
+
 auto world() -> Result<int, NestedError> {
     return ok<int, NestedError>(0);
 }
 
 auto hello() -> Result<int, RootError> {
-    return world().map_err([] (NestedError) { return RootError::Hello; });
+    return world();
 }
 
-auto test_nested_error() {
-    unwrap(hello());
+// Same conversion, but NestedError is kept as the cause of the RootError
+auto hello_with_cause() -> Result<int, Chain<RootError>> {
+    return wrap_err(world(), [] (NestedError) { return RootError::Hello; }, "greeting the world");
 }
 
-enum class ParseError {
-    Empty, 
-    NotANumber 
-};
-
-template<>
-struct Display<ParseError> {
-    static void print(ParseError e) {
-        switch(e) {
-            case ParseError::Empty: std::cerr << "Error: input was empty\n"; break;
-            case ParseError::NotANumber: std::cerr << "Error: not a number\n"; break;
-        }
-    }
-};
-
-// Try to parse an integer; empty string or non‑digits produce errors
-Result<int, ParseError> parse_int(const std::string& s) {
-    if (s.empty()) {
-        return err<int,ParseError>(ParseError::Empty);
-    }
-
-    for (char c : s) {
-        if (!isdigit(c)) {
-            return err<int, ParseError>(ParseError::NotANumber);
-        }
-    }
+auto test_nested_error() {
+    unwrap(hello());
 
-    return ok<int, ParseError>(std::stoi(s));
+    ArenaScope scope;
+    unwrap(hello_with_cause());
 }
 
 // Validate that the number is positive
@@ -83,15 +69,15 @@ Result<void, ParseError> validate_positive(int x) {
 
 int main() {
     // Fatal: must parse or exit
-    int n = unwrap(parse_int("123"));
+    int n = unwrap(parse<int>("123"));
     assert(n == 123);
 
     // Non‑fatal: fallback to zero
-    int m = unwrap_or(parse_int(""), 0);
+    int m = unwrap_or(parse<int>(""), 0);
     assert(m == 0);
 
     // Non‑fatal with custom handler
-    int k = unwrap_or_else(parse_int("abc"), [] (ParseError){
+    int k = unwrap_or_else(parse<int>("abc"), [] (ParseError){
         return 42;
     });
     assert(k == 42);
@@ -111,7 +97,7 @@ int main() {
     assert(cleaned);
 
     // Map value into different type
-    auto c = parse_int("42")
+    auto c = parse<int>("42")
         .map([] (int i) -> char {
             return static_cast<char>(i);
         })
@@ -120,7 +106,7 @@ int main() {
 
     // Linear execution
     auto check = false;
-    parse_int("234")
+    parse<int>("234")
         .and_then([&] (int) {
             check = true;
             return ok<ParseError>();
@@ -129,7 +115,7 @@ int main() {
 
     // Match result
     auto check_flow = false;
-    auto i = parse_int("1234");
+    auto i = parse<int>("1234");
     match(
         i,
         [&] (int ii) {
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "result.hpp"
+
+// Error of a file operation: which call failed and its errno. Shared by
+// MappedFile and IoRing.
+
+enum class IoOp : std::uint8_t {
+    Open,
+    Stat,
+    Map,
+    Advise,
+    Read,
+    Write,
+    Submit,
+};
+
+struct IoError {
+    IoOp op;
+    int errnum; // errno of the failed call
+
+    auto operator==(const IoError&) const -> bool = default;
+};
+
+template<>
+struct Display<IoError> {
+    static void print(const IoError& e) {
+        static constexpr const char* names[] = { "open", "fstat", "mmap", "madvise", "read", "write", "io_uring_enter" };
+        std::fprintf(stderr, "io error: %s: %s\n", names[static_cast<int>(e.op)], std::strerror(e.errnum));
+    }
+};
@@ -0,0 +1,391 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "io_error.hpp"
+#include "result.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define RESULT_IO_URING 1
+#else
+#define RESULT_IO_URING 0
+#endif
+
+// Batched asynchronous reads and writes at explicit offsets. Requests are
+// queued without a syscall, submit() hands the whole batch to the kernel in
+// one io_uring_enter, and completions are reaped from the shared completion
+// ring without a syscall at all. Each completion is a Result built from the
+// kernel's return value: the byte count, or an IoError with its errno.
+//
+// Where io_uring is missing or blocked (old kernels, seccomp filters), or
+// predates IORING_OP_READ/WRITE (before 5.6), the ring falls back to
+// pread/pwrite, run at submit(); the interface and the results are the same.
+//
+//   IoRing ring(64);
+//   auto h = unwrap(ring.read(fd, buf, 4096, offset)); // queued
+//   unwrap(ring.submit());                              // one syscall per batch
+//   ring.wait(1, [&](IoHandle done, Result<std::size_t, IoError> n) { ... });
+
+struct IoHandle {
+    std::uint64_t id;
+
+    auto operator==(const IoHandle&) const -> bool = default;
+};
+
+enum class IoBackend : std::uint8_t {
+    IoUring,
+    Sync, // pread/pwrite during submit()
+};
+
+namespace detail {
+
+#if RESULT_IO_URING
+
+// The rings shared with the kernel. Head and tail indices are free-running;
+// the kernel advances the submission head and the completion tail.
+struct Uring {
+    int fd = -1;
+    void* sq_ring = nullptr;
+    void* cq_ring = nullptr;
+    std::size_t sq_ring_size = 0;
+    std::size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = nullptr;
+    std::size_t sqes_size = 0;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_mask = 0;
+    unsigned sq_entries = 0;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    unsigned cq_entries = 0;
+    io_uring_cqe* cqes = nullptr;
+};
+
+inline auto ring_at(void* ring, std::uint32_t offset) -> unsigned* {
+    return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+}
+
+inline auto unmap_uring(Uring& u) -> void {
+    if (u.sqes != nullptr) {
+        ::munmap(u.sqes, u.sqes_size);
+    }
+    if (u.cq_ring != nullptr && u.cq_ring != u.sq_ring) {
+        ::munmap(u.cq_ring, u.cq_ring_size);
+    }
+    if (u.sq_ring != nullptr) {
+        ::munmap(u.sq_ring, u.sq_ring_size);
+    }
+    if (u.fd >= 0) {
+        ::close(u.fd);
+    }
+    u = Uring {};
+}
+
+inline auto map_ring(int fd, std::size_t size, off_t offset) -> void* {
+    auto p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// Whether the kernel implements IORING_OP_READ and IORING_OP_WRITE. Kernels
+// before 5.6 lack both, and IORING_REGISTER_PROBE as well.
+inline auto probe_read_write(int fd) -> bool {
+    constexpr unsigned ops = 64;
+    alignas(io_uring_probe) std::byte storage[sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op)] = {};
+    auto probe = reinterpret_cast<io_uring_probe*>(storage);
+    if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, ops) < 0) {
+        return false;
+    }
+    auto supported = [&](unsigned op) {
+        return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    };
+    return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+}
+
+// False when io_uring cannot be used, leaving u empty
+inline auto setup_uring(unsigned entries, Uring& u) -> bool {
+    io_uring_params p {};
+    u.fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (u.fd < 0) {
+        u.fd = -1;
+        return false;
+    }
+    if (!probe_read_write(u.fd)) {
+        unmap_uring(u);
+        return false;
+    }
+    u.sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u.cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    auto single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        u.sq_ring_size = u.cq_ring_size = std::max(u.sq_ring_size, u.cq_ring_size);
+    }
+    u.sq_ring = map_ring(u.fd, u.sq_ring_size, IORING_OFF_SQ_RING);
+    u.cq_ring = single ? u.sq_ring : map_ring(u.fd, u.cq_ring_size, IORING_OFF_CQ_RING);
+    u.sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    u.sqes = static_cast<io_uring_sqe*>(map_ring(u.fd, u.sqes_size, IORING_OFF_SQES));
+    if (u.sq_ring == nullptr || u.cq_ring == nullptr || u.sqes == nullptr) {
+        unmap_uring(u);
+        return false;
+    }
+    u.sq_tail = ring_at(u.sq_ring, p.sq_off.tail);
+    u.sq_array = ring_at(u.sq_ring, p.sq_off.array);
+    u.sq_mask = *ring_at(u.sq_ring, p.sq_off.ring_mask);
+    u.sq_entries = p.sq_entries;
+    u.cq_head = ring_at(u.cq_ring, p.cq_off.head);
+    u.cq_tail = ring_at(u.cq_ring, p.cq_off.tail);
+    u.cq_mask = *ring_at(u.cq_ring, p.cq_off.ring_mask);
+    u.cq_entries = p.cq_entries;
+    u.cqes = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(u.cq_ring) + p.cq_off.cqes);
+    return true;
+}
+
+#endif
+
+// Negative results are -errno, as in a CQE
+inline auto io_completion(bool write, std::int64_t res) -> Result<std::size_t, IoError> {
+    if (res < 0) [[unlikely]] {
+        return err<std::size_t, IoError>(IoError { write ? IoOp::Write : IoOp::Read, static_cast<int>(-res) });
+    }
+    return ok<std::size_t, IoError>(static_cast<std::size_t>(res));
+}
+
+} // namespace detail
+
+class IoRing {
+public:
+    // Room for `entries` queued requests; the kernel rounds it up to a
+    // power of two. Asking for IoBackend::Sync skips io_uring.
+    explicit IoRing(unsigned entries = 64, IoBackend backend = IoBackend::IoUring) : capacity(entries) {
+#if RESULT_IO_URING
+        if (backend == IoBackend::IoUring && detail::setup_uring(entries, uring)) {
+            capacity = uring.sq_entries;
+            max_pending = uring.cq_entries;
+            return;
+        }
+#endif
+        (void)backend;
+        kind = IoBackend::Sync;
+    }
+
+    IoRing(const IoRing&) = delete;
+    auto operator=(const IoRing&) -> IoRing& = delete;
+
+    IoRing(IoRing&& other) noexcept
+        : kind(other.kind),
+          capacity(other.capacity),
+          max_pending(other.max_pending),
+#if RESULT_IO_URING
+          uring(std::exchange(other.uring, {})),
+#endif
+          queued(std::exchange(other.queued, 0)),
+          pending(std::exchange(other.pending, 0)),
+          next_id(other.next_id),
+          requests(std::move(other.requests)),
+          done(std::move(other.done)) {
+        other.kind = IoBackend::Sync;
+    }
+
+    auto operator=(IoRing&& other) noexcept -> IoRing& {
+        if (this != &other) {
+#if RESULT_IO_URING
+            detail::unmap_uring(uring);
+            uring = std::exchange(other.uring, {});
+#endif
+            kind = std::exchange(other.kind, IoBackend::Sync);
+            capacity = other.capacity;
+            max_pending = other.max_pending;
+            queued = std::exchange(other.queued, 0);
+            pending = std::exchange(other.pending, 0);
+            next_id = other.next_id;
+            requests = std::move(other.requests);
+            done = std::move(other.done);
+        }
+        return *this;
+    }
+
+    ~IoRing() {
+#if RESULT_IO_URING
+        detail::unmap_uring(uring);
+#endif
+    }
+
+    auto backend() const -> IoBackend {
+        return kind;
+    }
+
+    // Requests queued or submitted whose completion has not been reaped
+    auto in_flight() const -> unsigned {
+        return pending;
+    }
+
+    // Queues a read of up to len bytes at offset. buf must stay valid until
+    // the completion is reaped. A full queue is submitted first. Fails when
+    // that submit fails, and with EBUSY when as many requests are in flight
+    // as the completion ring holds (twice the queue size with io_uring);
+    // reap some with poll or wait first.
+    auto read(int fd, void* buf, std::uint32_t len, std::uint64_t offset) -> Result<IoHandle, IoError> {
+        return prepare(false, fd, buf, len, offset);
+    }
+
+    auto write(int fd, const void* buf, std::uint32_t len, std::uint64_t offset) -> Result<IoHandle, IoError> {
+        return prepare(true, fd, const_cast<void*>(buf), len, offset);
+    }
+
+    // Hands the queued requests to the kernel and returns how many
+    auto submit() -> Result<unsigned, IoError> {
+        return flush(0);
+    }
+
+    // Calls f(handle, result) for every completion that is ready, without
+    // blocking, and returns their number. f may queue and submit requests
+    // but must not poll or wait on this ring.
+    template<typename F>
+    auto poll(F&& f) -> unsigned {
+        unsigned n = 0;
+#if RESULT_IO_URING
+        if (kind == IoBackend::IoUring) {
+            auto head = *uring.cq_head;
+            while (head != std::atomic_ref<unsigned>(*uring.cq_tail).load(std::memory_order_acquire)) {
+                auto cqe = uring.cqes[head & uring.cq_mask];
+                // Release the slot before f runs, so f can queue more work
+                std::atomic_ref<unsigned>(*uring.cq_head).store(++head, std::memory_order_release);
+                --pending;
+                ++n;
+                f(IoHandle { cqe.user_data >> 1 }, detail::io_completion(cqe.user_data & 1, cqe.res));
+            }
+            return n;
+        }
+#endif
+        for (std::size_t i = 0; i < done.size(); ++i) {
+            auto c = done[i];
+            --pending;
+            ++n;
+            f(IoHandle { c.user_data >> 1 }, detail::io_completion(c.user_data & 1, c.res));
+        }
+        done.clear();
+        return n;
+    }
+
+    // Submits what is queued, blocks until at least min completions are
+    // ready (never more than are in flight), then reaps them as poll does
+    template<typename F>
+    auto wait(unsigned min, F&& f) -> Result<unsigned, IoError> {
+        if (auto r = flush(std::min(min, pending)); r.tag == Result<unsigned, IoError>::Tag::Err) {
+            return r;
+        }
+        return ok<unsigned, IoError>(poll(std::forward<F>(f)));
+    }
+
+private:
+    struct Request {
+        std::uint64_t user_data; // id << 1 | write
+        int fd;
+        void* buf;
+        std::uint32_t len;
+        std::uint64_t offset;
+    };
+
+    struct Completion {
+        std::uint64_t user_data;
+        std::int64_t res;
+    };
+
+    auto prepare(bool write, int fd, void* buf, std::uint32_t len, std::uint64_t offset) -> Result<IoHandle, IoError> {
+        if (pending == max_pending) [[unlikely]] {
+            return err<IoHandle, IoError>(IoError { IoOp::Submit, EBUSY });
+        }
+        // The kernel may consume fewer entries than queued
+        while (queued == capacity) [[unlikely]] {
+            auto r = submit();
+            if (r.tag == Result<unsigned, IoError>::Tag::Err) {
+                return err<IoHandle, IoError>(r.error);
+            }
+            if (r.value == 0) {
+                return err<IoHandle, IoError>(IoError { IoOp::Submit, EAGAIN });
+            }
+        }
+        auto id = next_id++;
+        auto user_data = id << 1 | std::uint64_t(write);
+#if RESULT_IO_URING
+        if (kind == IoBackend::IoUring) {
+            auto tail = *uring.sq_tail;
+            auto index = tail & uring.sq_mask;
+            auto& sqe = uring.sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(buf);
+            sqe.len = len;
+            sqe.off = offset;
+            sqe.user_data = user_data;
+            uring.sq_array[index] = index;
+            std::atomic_ref<unsigned>(*uring.sq_tail).store(tail + 1, std::memory_order_release);
+            ++queued;
+            ++pending;
+            return ok<IoHandle, IoError>(IoHandle { id });
+        }
+#endif
+        requests.push_back(Request { user_data, fd, buf, len, offset });
+        ++queued;
+        ++pending;
+        return ok<IoHandle, IoError>(IoHandle { id });
+    }
+
+    // Submits the queued requests, waiting for min_complete completions
+    auto flush(unsigned min_complete) -> Result<unsigned, IoError> {
+#if RESULT_IO_URING
+        if (kind == IoBackend::IoUring) {
+            if (queued == 0 && min_complete == 0) {
+                return ok<unsigned, IoError>(0);
+            }
+            auto flags = min_complete != 0 ? IORING_ENTER_GETEVENTS : 0u;
+            for (;;) {
+                auto n = ::syscall(__NR_io_uring_enter, uring.fd, queued, min_complete, flags, nullptr, 0);
+                if (n >= 0) {
+                    queued -= static_cast<unsigned>(n);
+                    return ok<unsigned, IoError>(static_cast<unsigned>(n));
+                }
+                if (errno != EINTR) {
+                    return err<unsigned, IoError>(IoError { IoOp::Submit, errno });
+                }
+            }
+        }
+#endif
+        // Sync backend: every request completes here
+        (void)min_complete;
+        for (auto& r : requests) {
+            ssize_t n;
+            do {
+                n = (r.user_data & 1) ? ::pwrite(r.fd, r.buf, r.len, static_cast<off_t>(r.offset))
+                                      : ::pread(r.fd, r.buf, r.len, static_cast<off_t>(r.offset));
+            } while (n < 0 && errno == EINTR);
+            done.push_back(Completion { r.user_data, n < 0 ? -std::int64_t(errno) : std::int64_t(n) });
+        }
+        auto n = static_cast<unsigned>(requests.size());
+        requests.clear();
+        queued = 0;
+        return ok<unsigned, IoError>(n);
+    }
+
+    IoBackend kind = IoBackend::IoUring;
+    unsigned capacity;
+    unsigned max_pending = ~0u; // the completion ring's size with io_uring
+#if RESULT_IO_URING
+    detail::Uring uring;
+#endif
+    unsigned queued = 0;  // prepared, not yet submitted
+    unsigned pending = 0; // prepared, not yet reaped
+    std::uint64_t next_id = 0;
+    std::vector<Request> requests; // Sync backend only
+    std::vector<Completion> done;
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "io_error.hpp"
+#include "result.hpp"
+
+// Read-only memory-mapped files. MappedFile::open wraps open/fstat/mmap and
+// returns the first failure as an IoError carrying errno; the mapping is
+// released on destruction. Reads go straight to the page cache, and text()
+// hands the mapping to the string_view parsers without a copy:
+//
+//   auto file = MappedFile::open("data.csv");  // Result<MappedFile, IoError>
+//   auto column = parse_fields(unwrap(std::move(file)).text(), '\n');
+
+enum class Advice : std::uint8_t {
+    Normal,
+    Sequential, // aggressive read-ahead, pages can be dropped behind the reader
+    Random,     // no read-ahead
+    WillNeed,   // start reading the whole file in now
+    HugePages,  // back the mapping with transparent huge pages where supported
+};
+
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : base(std::exchange(other.base, nullptr)), length(std::exchange(other.length, 0)) {}
+
+    auto operator=(MappedFile&& other) noexcept -> MappedFile& {
+        if (this != &other) {
+            unmap();
+            base = std::exchange(other.base, nullptr);
+            length = std::exchange(other.length, 0);
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+        unmap();
+    }
+
+    // Maps the whole file read-only. The descriptor is closed again right
+    // away; the mapping keeps the file contents alive. An empty file maps
+    // to an empty span.
+    static auto open(const char* path) -> Result<MappedFile, IoError> {
+        int fd;
+        do {
+            fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        } while (fd < 0 && errno == EINTR);
+        if (fd < 0) {
+            return err<MappedFile, IoError>(IoError { IoOp::Open, errno });
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            auto e = errno;
+            ::close(fd);
+            return err<MappedFile, IoError>(IoError { IoOp::Stat, e });
+        }
+
+        MappedFile file;
+        file.length = static_cast<std::size_t>(st.st_size);
+        if (file.length != 0) {
+            auto p = ::mmap(nullptr, file.length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                auto e = errno;
+                ::close(fd);
+                return err<MappedFile, IoError>(IoError { IoOp::Map, e });
+            }
+            file.base = p;
+        }
+        ::close(fd);
+        return ok<MappedFile, IoError>(std::move(file));
+    }
+
+    auto advise(Advice advice) const -> Result<void, IoError> {
+        if (length == 0) {
+            return ok<IoError>();
+        }
+        if (::madvise(base, length, native_advice(advice)) != 0) {
+            return err<void, IoError>(IoError { IoOp::Advise, errno });
+        }
+        return ok<IoError>();
+    }
+
+    auto bytes() const -> std::span<const std::byte> {
+        return { static_cast<const std::byte*>(base), length };
+    }
+
+    auto text() const -> std::string_view {
+        return { static_cast<const char*>(base), length };
+    }
+
+    auto size() const -> std::size_t {
+        return length;
+    }
+
+private:
+    static auto native_advice(Advice advice) -> int {
+        switch (advice) {
+            case Advice::Normal: return MADV_NORMAL;
+            case Advice::Sequential: return MADV_SEQUENTIAL;
+            case Advice::Random: return MADV_RANDOM;
+            case Advice::WillNeed: return MADV_WILLNEED;
+#ifdef MADV_HUGEPAGE
+            case Advice::HugePages: return MADV_HUGEPAGE;
+#else
+            case Advice::HugePages: return -1; // madvise fails with EINVAL
+#endif
+        }
+        return MADV_NORMAL;
+    }
+
+    auto unmap() -> void {
+        if (base != nullptr) {
+            ::munmap(base, length);
+            base = nullptr;
+            length = 0;
+        }
+    }
+
+    void* base = nullptr;
+    std::size_t length = 0;
+};
@@ -0,0 +1,202 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include "coarse_clock.hpp"
+#include "result.hpp"
+
+// Caches the outcomes of an expensive Result-returning function of one key.
+// Ok and Err outcomes are kept for separate TTLs, so a failing lookup is
+// not retried on every call either (negative caching). The cache is split
+// into shards with their own lock; hits take it shared. Each shard holds a
+// fixed number of entries and evicts with CLOCK: a hit sets the entry's
+// reference bit, and the eviction hand skips, and clears, entries whose bit
+// is set. Expired entries are taken whatever their bit.
+//
+//   auto lookup = memoize<std::string>(resolve_host, { .ok_ttl = 60s, .err_ttl = 5s });
+//   auto addr = lookup("example.com"); // Result<Address, DnsError>
+//
+// A hit does not allocate. Small trivially copyable values are returned by
+// copy; anything else is returned as a shared_ptr<const T> to the cached
+// value, which stays valid after the entry is evicted. Errors that are not
+// trivially copyable (std::string, DynError, ...) are shared the same way,
+// as shared_ptr<const E>. f runs without a
+// lock held, so concurrent misses on the same key may each call it. Expiry
+// is checked against the coarse monotonic clock, so TTLs are accurate to a
+// few milliseconds.
+
+struct MemoOptions {
+    std::size_t capacity = 4096; // entries across all shards
+    std::chrono::milliseconds ok_ttl { 60000 };
+    std::chrono::milliseconds err_ttl { 1000 }; // 0 disables negative caching
+    std::size_t shards = 16;
+};
+
+template<typename K, typename F, typename Hash = std::hash<K>>
+class Memoized {
+    using Computed = std::invoke_result_t<F&, const K&>;
+    using T = typename Computed::value_type;
+    using E = typename Computed::error_type;
+
+public:
+    static constexpr bool by_copy = std::is_trivially_copyable_v<T> && sizeof(T) <= 2 * sizeof(void*);
+
+    static constexpr bool error_by_copy = std::is_trivially_copyable_v<E>;
+
+    using Value = std::conditional_t<by_copy, T, std::shared_ptr<const T>>;
+    using Error = std::conditional_t<error_by_copy, E, std::shared_ptr<const E>>;
+    using Output = Result<Value, Error>;
+
+    Memoized(F f, MemoOptions options)
+        : f(std::move(f)),
+          ok_ttl_ns(to_ns(options.ok_ttl)),
+          err_ttl_ns(to_ns(options.err_ttl)),
+          shard_count(options.shards == 0 ? 1 : options.shards),
+          per_shard(options.capacity / shard_count == 0 ? 1 : options.capacity / shard_count),
+          shards(std::make_unique<Shard[]>(shard_count)) {
+        for (std::size_t i = 0; i < shard_count; ++i) {
+            shards[i].entries = std::make_unique<Entry[]>(per_shard);
+            shards[i].index.reserve(per_shard);
+        }
+    }
+
+    auto operator()(const K& key) -> Output {
+        auto& shard = shards[Hash {}(key) % shard_count];
+        auto now = detail::coarse_now_ns();
+        {
+            std::shared_lock lock(shard.mutex);
+            if (auto it = shard.index.find(key); it != shard.index.end()) {
+                auto& entry = shard.entries[it->second];
+                if (now < entry.expires) [[likely]] {
+                    entry.referenced.store(true, std::memory_order_relaxed);
+                    return *entry.result;
+                }
+            }
+        }
+
+        auto out = wrap(f(key));
+        auto ttl = out.tag == Output::Tag::Ok ? ok_ttl_ns : err_ttl_ns;
+        if (ttl != 0) {
+            std::unique_lock lock(shard.mutex);
+            auto it = shard.index.find(key);
+            auto slot = it != shard.index.end() ? it->second : claim(shard, now);
+            auto& entry = shard.entries[slot];
+            if (it == shard.index.end()) {
+                shard.index.emplace(key, slot);
+                entry.key.emplace(key);
+            }
+            entry.result.emplace(out);
+            entry.expires = now + ttl;
+            entry.referenced.store(false, std::memory_order_relaxed);
+        }
+        return out;
+    }
+
+    // Drops key's entry, if any, so the next call computes it again
+    auto invalidate(const K& key) -> void {
+        auto& shard = shards[Hash {}(key) % shard_count];
+        std::unique_lock lock(shard.mutex);
+        if (auto it = shard.index.find(key); it != shard.index.end()) {
+            // The hand reuses entries without a key
+            auto& entry = shard.entries[it->second];
+            entry.key.reset();
+            entry.result.reset();
+            shard.index.erase(it);
+        }
+    }
+
+    // Cached entries, including expired ones not yet evicted
+    auto size() const -> std::size_t {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < shard_count; ++i) {
+            std::shared_lock lock(shards[i].mutex);
+            n += shards[i].index.size();
+        }
+        return n;
+    }
+
+private:
+    struct Entry {
+        std::optional<K> key;
+        std::optional<Output> result;
+        std::uint64_t expires = 0; // coarse_now_ns()
+        std::atomic<bool> referenced { false };
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<K, std::size_t, Hash> index;
+        std::unique_ptr<Entry[]> entries;
+        std::size_t used = 0; // entries[0, used) have been handed out
+        std::size_t hand = 0;
+    };
+
+    static auto to_ns(std::chrono::milliseconds ttl) -> std::uint64_t {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(ttl).count());
+    }
+
+    static auto wrap(Computed&& r) -> Output {
+        if (r.tag == Computed::Tag::Err) {
+            if constexpr (error_by_copy) {
+                return err<Value, Error>(r.error);
+            } else {
+                return err<Value, Error>(std::make_shared<const E>(std::move(r.error)));
+            }
+        }
+        if constexpr (by_copy) {
+            return ok<Value, Error>(r.value);
+        } else {
+            return ok<Value, Error>(std::make_shared<const T>(std::move(r.value)));
+        }
+    }
+
+    // A free entry, evicting one when the shard is full
+    auto claim(Shard& shard, std::uint64_t now) -> std::size_t {
+        if (shard.used < per_shard) {
+            return shard.used++;
+        }
+        for (;;) {
+            auto slot = shard.hand;
+            shard.hand = (shard.hand + 1) % per_shard;
+            auto& entry = shard.entries[slot];
+            if (!entry.key) {
+                return slot; // invalidated
+            }
+            if (entry.expires <= now || !entry.referenced.exchange(false, std::memory_order_relaxed)) {
+                shard.index.erase(*entry.key);
+                entry.key.reset();
+                entry.result.reset();
+                return slot;
+            }
+        }
+    }
+
+    F f;
+    std::uint64_t ok_ttl_ns;
+    std::uint64_t err_ttl_ns;
+    std::size_t shard_count;
+    std::size_t per_shard;
+    std::unique_ptr<Shard[]> shards;
+};
+
+// Shared errors of a memoized function print as the error itself
+template<typename E>
+struct Display<std::shared_ptr<const E>> {
+    static void print(const std::shared_ptr<const E>& e) {
+        Display<E>::print(*e);
+    }
+};
+
+template<typename K, typename F, typename Hash = std::hash<K>>
+auto memoize(F f, MemoOptions options = {}) -> Memoized<K, F, Hash> {
+    return Memoized<K, F, Hash>(std::move(f), options);
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include "result.hpp"
+
+// Errors with a human-readable message that never touch the heap.
+// InlineMessage<N> formats eagerly into a fixed buffer, truncating what does
+// not fit. LazyMessage<N> only captures the format string and its arguments
+// and renders them when printed, so an error that is handled without being
+// shown costs a few stores. Both are trivially copyable, so a Result holding
+// them keeps the trivial special members. The lazy form keeps pointers as
+// they are: the format string and any `const char*` argument must outlive
+// the error, which string literals do.
+//
+//   return err<int, LazyMessage<>>(lazy_message("port %d out of range", port));
+
+template<std::size_t N = 64>
+class InlineMessage {
+    static_assert(N > 1 && N <= 65536, "InlineMessage<N>: N must be in [2, 65536]");
+
+public:
+    InlineMessage() {
+        text[0] = '\0';
+    }
+
+    InlineMessage(std::string_view s) {
+        assign(s);
+    }
+
+    InlineMessage(const char* s) : InlineMessage(std::string_view(s)) {}
+
+    template<typename... Args>
+    static auto format(const char* fmt, Args... args) -> InlineMessage {
+        static_assert((std::is_trivially_copyable_v<Args> && ...), "InlineMessage::format: printf arguments only");
+        InlineMessage m;
+        int n;
+        if constexpr (sizeof...(Args) == 0) {
+            n = std::snprintf(m.text, N, "%s", fmt);
+        } else {
+            n = std::snprintf(m.text, N, fmt, args...);
+        }
+        m.set_length(n);
+        return m;
+    }
+
+    auto c_str() const -> const char* {
+        return text;
+    }
+
+    auto view() const -> std::string_view {
+        return { text, length };
+    }
+
+    auto size() const -> std::size_t {
+        return length;
+    }
+
+    auto truncated() const -> bool {
+        return cut;
+    }
+
+private:
+    auto assign(std::string_view s) -> void {
+        cut = s.size() >= N;
+        length = static_cast<std::uint16_t>(cut ? N - 1 : s.size());
+        std::memcpy(text, s.data(), length);
+        text[length] = '\0';
+    }
+
+    auto set_length(int n) -> void {
+        if (n < 0) {
+            n = 0;
+            text[0] = '\0';
+        }
+        cut = static_cast<std::size_t>(n) >= N;
+        length = static_cast<std::uint16_t>(cut ? N - 1 : n);
+    }
+
+    char text[N];
+    std::uint16_t length = 0;
+    bool cut = false;
+};
+
+template<std::size_t N>
+struct Display<InlineMessage<N>> {
+    static void print(const InlineMessage<N>& m) {
+        std::fprintf(stderr, "%s%s\n", m.c_str(), m.truncated() ? "..." : "");
+    }
+};
+
+namespace detail {
+
+// Trivially copyable stand-in for std::tuple, whose assignment operators are
+// user-provided.
+template<typename... Args>
+struct ArgPack {};
+
+template<typename Head, typename... Tail>
+struct ArgPack<Head, Tail...> {
+    Head head;
+    [[no_unique_address]] ArgPack<Tail...> tail;
+};
+
+inline auto make_pack() -> ArgPack<> {
+    return {};
+}
+
+template<typename Head, typename... Tail>
+auto make_pack(Head head, Tail... tail) -> ArgPack<Head, Tail...> {
+    return { head, make_pack(tail...) };
+}
+
+template<typename F, typename... Done>
+auto apply_pack(F&& f, const ArgPack<>&, const Done&... done) {
+    return f(done...);
+}
+
+template<typename F, typename Head, typename... Tail, typename... Done>
+auto apply_pack(F&& f, const ArgPack<Head, Tail...>& pack, const Done&... done) {
+    return apply_pack(f, pack.tail, done..., pack.head);
+}
+
+} // namespace detail
+
+// The arguments are stored in an inline byte buffer; the only code generated
+// per argument pack is the render function that unpacks them again.
+template<std::size_t N = 32>
+class LazyMessage {
+public:
+    LazyMessage() = default;
+
+    template<typename... Args>
+    LazyMessage(const char* fmt, Args... args) : fmt(fmt), render_fn(&render_with<Args...>) {
+        using Pack = detail::ArgPack<Args...>;
+        static_assert((std::is_trivially_copyable_v<Args> && ...), "LazyMessage: printf arguments only");
+        static_assert(sizeof(Pack) <= N, "LazyMessage: arguments do not fit, raise N");
+        static_assert(alignof(Pack) <= alignof(std::uint64_t), "LazyMessage: over-aligned argument");
+        ::new (static_cast<void*>(args_storage)) Pack(detail::make_pack(args...));
+    }
+
+    auto format_string() const -> const char* {
+        return fmt;
+    }
+
+    // Formats into `out` like snprintf and returns the untruncated length.
+    auto render_to(char* out, std::size_t size) const -> int {
+        if (render_fn == nullptr) {
+            return std::snprintf(out, size, "%s", "");
+        }
+        return render_fn(out, size, fmt, args_storage);
+    }
+
+    template<std::size_t M = 64>
+    auto render() const -> InlineMessage<M> {
+        char text[M];
+        render_to(text, M);
+        return InlineMessage<M>(std::string_view(text));
+    }
+
+    auto print() const -> void {
+        char text[256];
+        auto n = render_to(text, sizeof(text));
+        std::fprintf(stderr, "%s%s\n", text, n >= static_cast<int>(sizeof(text)) ? "..." : "");
+    }
+
+private:
+    using RenderFn = int (*)(char*, std::size_t, const char*, const std::byte*);
+
+    template<typename... Args>
+    static auto render_with(char* out, std::size_t size, const char* fmt, const std::byte* storage) -> int {
+        if constexpr (sizeof...(Args) == 0) {
+            return std::snprintf(out, size, "%s", fmt);
+        } else {
+            auto& pack = *std::launder(reinterpret_cast<const detail::ArgPack<Args...>*>(storage));
+            return detail::apply_pack([&] (const auto&... args) { return std::snprintf(out, size, fmt, args...); }, pack);
+        }
+    }
+
+    const char* fmt = nullptr;
+    RenderFn render_fn = nullptr;
+    alignas(std::uint64_t) std::byte args_storage[N];
+};
+
+template<std::size_t N>
+struct Display<LazyMessage<N>> {
+    static void print(const LazyMessage<N>& m) {
+        m.print();
+    }
+};
+
+template<std::size_t N = 32, typename... Args>
+auto lazy_message(const char* fmt, Args... args) -> LazyMessage<N> {
+    return LazyMessage<N>(fmt, args...);
+}
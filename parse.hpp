@@ -0,0 +1,73 @@
+#pragma once
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include "result.hpp"
+
+// Number parsing over string_view in a single std::from_chars pass: no
+// locale, no allocation, no exceptions. The whole input must be consumed;
+// leading whitespace, a leading '+' and trailing characters are NotANumber,
+// a value outside the range of T is Overflow.
+//
+//   auto port = parse<std::uint16_t>(arg);
+//   auto ratio = parse<double>("0.75");
+
+enum class ParseError : std::uint8_t {
+    Empty,
+    NotANumber,
+    Overflow,
+};
+
+template<>
+struct Display<ParseError> {
+    static void print(ParseError e) {
+        switch (e) {
+            case ParseError::Empty: std::fputs("parse error: input was empty\n", stderr); break;
+            case ParseError::NotANumber: std::fputs("parse error: not a number\n", stderr); break;
+            case ParseError::Overflow: std::fputs("parse error: out of range\n", stderr); break;
+        }
+    }
+};
+
+namespace detail {
+
+template<typename T>
+concept Parsable = (std::integral<T> && !std::same_as<T, bool>) || std::floating_point<T>;
+
+template<typename T>
+auto finish_parse(std::from_chars_result r, T value, std::string_view s) -> Result<T, ParseError> {
+    if (r.ec == std::errc {} && r.ptr == s.data() + s.size()) [[likely]] {
+        return ok<T, ParseError>(value);
+    }
+    if (r.ec == std::errc::result_out_of_range) {
+        return err<T, ParseError>(ParseError::Overflow);
+    }
+    return err<T, ParseError>(ParseError::NotANumber);
+}
+
+} // namespace detail
+
+template<detail::Parsable T>
+auto parse(std::string_view s) -> Result<T, ParseError> {
+    if (s.empty()) {
+        return err<T, ParseError>(ParseError::Empty);
+    }
+    T value {};
+    auto r = std::from_chars(s.data(), s.data() + s.size(), value);
+    return detail::finish_parse(r, value, s);
+}
+
+template<std::integral T>
+requires detail::Parsable<T>
+auto parse(std::string_view s, int base) -> Result<T, ParseError> {
+    if (s.empty()) {
+        return err<T, ParseError>(ParseError::Empty);
+    }
+    T value {};
+    auto r = std::from_chars(s.data(), s.data() + s.size(), value, base);
+    return detail::finish_parse(r, value, s);
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <unistd.h>
+#include "result.hpp"
+
+// Streaming reader for delimited records (lines of a log, rows of a CSV)
+// over a file descriptor. It reads into one fixed buffer and hands out
+// string_views into it, so memory use is the buffer size whatever the input
+// size. A record that spans two reads is moved to the front of the buffer
+// before the next read. A view is valid until the next record is read.
+//
+//   RecordReader reader(fd);
+//   for (auto row : reader.records(parse_row)) { ... } // Result<Row, E> per record
+//   unwrap(reader.status());                             // read errors end the loop
+
+enum class ReadError : std::uint8_t {
+    Io,            // read(2) failed, see RecordReader::error_number()
+    RecordTooLong, // a record does not fit in the buffer
+};
+
+template<>
+struct Display<ReadError> {
+    static void print(ReadError e) {
+        switch (e) {
+            case ReadError::Io: std::fputs("read error: I/O failure\n", stderr); break;
+            case ReadError::RecordTooLong: std::fputs("read error: record longer than the buffer\n", stderr); break;
+        }
+    }
+};
+
+template<typename F>
+class RecordRange;
+
+class RecordReader {
+public:
+    static constexpr std::size_t default_capacity = 64 * 1024;
+
+    // Does not take ownership of fd
+    explicit RecordReader(int fd, char delim = '\n', std::size_t capacity = default_capacity)
+        : fd(fd), delim(delim), capacity(capacity), buf(std::make_unique<char[]>(capacity)) {}
+
+    // The next record without its delimiter. Returns nullopt at the end of
+    // the input or after an error, which status() then reports. The last
+    // record does not need a trailing delimiter.
+    auto next() -> std::optional<std::string_view> {
+        for (;;) {
+            auto start = buf.get() + begin;
+            auto found = static_cast<const char*>(std::memchr(buf.get() + scan, delim, end - scan));
+            if (found != nullptr) [[likely]] {
+                auto record = std::string_view(start, static_cast<std::size_t>(found - start));
+                begin = scan = static_cast<std::size_t>(found - buf.get()) + 1;
+                return record;
+            }
+            if (eof || failed) {
+                if (begin == end) {
+                    return std::nullopt;
+                }
+                auto record = std::string_view(start, end - begin);
+                begin = scan = end;
+                return record;
+            }
+            // The partial record has no delimiter: search only the new bytes
+            scan = end;
+            refill();
+        }
+    }
+
+    template<typename F>
+    auto records(F parse) -> RecordRange<F> {
+        return RecordRange<F>(*this, std::move(parse));
+    }
+
+    auto status() const -> Result<void, ReadError> {
+        if (failed) {
+            return err<void, ReadError>(error);
+        }
+        return ok<ReadError>();
+    }
+
+    // errno of the failed read for ReadError::Io
+    auto error_number() const -> int {
+        return errnum;
+    }
+
+private:
+    [[gnu::noinline]] auto refill() -> void {
+        // Keep the partial record, drop everything before it
+        auto partial = end - begin;
+        if (begin != 0) {
+            std::memmove(buf.get(), buf.get() + begin, partial);
+            scan -= begin;
+            begin = 0;
+            end = partial;
+        }
+        if (end == capacity) {
+            fail(ReadError::RecordTooLong, 0);
+            return;
+        }
+        for (;;) {
+            auto n = ::read(fd, buf.get() + end, capacity - end);
+            if (n > 0) {
+                end += static_cast<std::size_t>(n);
+                return;
+            }
+            if (n == 0) {
+                eof = true;
+                return;
+            }
+            if (errno != EINTR) {
+                fail(ReadError::Io, errno);
+                return;
+            }
+        }
+    }
+
+    // The partial record is dropped rather than returned
+    auto fail(ReadError e, int errno_value) -> void {
+        failed = true;
+        error = e;
+        errnum = errno_value;
+        begin = scan = end;
+    }
+
+    int fd;
+    char delim;
+    std::size_t capacity;
+    std::unique_ptr<char[]> buf;
+    std::size_t begin = 0; // start of the current record
+    std::size_t scan = 0;  // where the delimiter search resumes
+    std::size_t end = 0;   // end of the bytes read so far
+    bool eof = false;
+    bool failed = false;
+    ReadError error = ReadError::Io;
+    int errnum = 0;
+};
+
+// Input range of parse(record) over the remaining records, where parse
+// returns a Result<Record, E>.
+template<typename F>
+class RecordRange {
+public:
+    using value_type = std::invoke_result_t<F&, std::string_view>;
+
+    class iterator {
+    public:
+        using value_type = RecordRange::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        auto operator*() const -> const value_type& {
+            return *current;
+        }
+
+        auto operator->() const -> const value_type* {
+            return &*current;
+        }
+
+        auto operator++() -> iterator& {
+            advance();
+            return *this;
+        }
+
+        auto operator++(int) -> void {
+            advance();
+        }
+
+        friend auto operator==(const iterator& it, std::default_sentinel_t) -> bool {
+            return !it.current.has_value();
+        }
+
+    private:
+        friend class RecordRange;
+
+        explicit iterator(RecordRange* range) : range(range) {
+            advance();
+        }
+
+        auto advance() -> void {
+            current.reset();
+            if (auto record = range->reader->next()) {
+                current.emplace(range->parse(*record));
+            }
+        }
+
+        RecordRange* range = nullptr;
+        std::optional<value_type> current;
+    };
+
+    RecordRange(RecordReader& reader, F parse) : reader(&reader), parse(std::move(parse)) {}
+
+    auto begin() -> iterator {
+        return iterator(this);
+    }
+
+    auto end() -> std::default_sentinel_t {
+        return {};
+    }
+
+private:
+    RecordReader* reader;
+    F parse;
+};
+
+// Calls on_record(parse(record)) for every remaining record. Returns the
+// number of records, or the read error that stopped the loop.
+template<typename F, typename G>
+auto for_each_record(RecordReader& reader, F&& parse, G&& on_record) -> Result<std::size_t, ReadError> {
+    std::size_t n = 0;
+    while (auto record = reader.next()) {
+        on_record(parse(*record));
+        ++n;
+    }
+    if (auto status = reader.status(); status.tag == Result<void, ReadError>::Tag::Err) {
+        return err<std::size_t, ReadError>(status.error);
+    }
+    return ok<std::size_t, ReadError>(n);
+}
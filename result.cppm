@@ -0,0 +1,36 @@
+// The `result` module: result.hpp as a C++20 module interface unit.
+//
+//   import result;
+//
+//   auto parse(int x) -> Result<int, ParseError> { ... }
+//
+// The standard headers are included in the global module fragment, so the
+// header's own includes of them are skipped, and the rest of result.hpp is
+// exported inside extern "C++". That keeps its names attached to the global
+// module: a TU that imports the module and one that includes result.hpp use
+// the same entities and can be linked together, and anything not built with
+// module support keeps including the header.
+//
+// Macros are not exported. The configuration macros (RESULT_TRACE_ORIGIN,
+// RESULT_STACK_SAMPLING, RESULT_PANIC_POLICY, ...) take effect when the
+// module is built and must match for every TU of a program. The
+// RESULT_EXTERN_TEMPLATE family still needs the header.
+
+module;
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <source_location>
+#include <type_traits>
+#include <utility>
+#include <execinfo.h>
+#include <unwind.h>
+export module result;
+
+export extern "C++" {
+#include "result.hpp"
+}
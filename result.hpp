@@ -1,16 +1,332 @@
 #pragma once
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <memory>
 #include <type_traits>
 #include <utility>
 
+// Error origin tracking: build with -DRESULT_TRACE_ORIGIN=1 to record the
+// source location of every err() and map_err() into a per-thread ring buffer.
+// When disabled the bookkeeping compiles away and Result keeps its layout.
+#ifndef RESULT_TRACE_ORIGIN
+#define RESULT_TRACE_ORIGIN 0
+#endif
+
+// Number of origin records kept per thread, older records are overwritten.
+#ifndef RESULT_TRACE_CAPACITY
+#define RESULT_TRACE_CAPACITY 256
+#endif
+
+// Sampled stack capture: build with -DRESULT_STACK_SAMPLING=1 to store the raw
+// return addresses of one in every N err() calls (see set_stack_sample_rate).
+// Frames are symbolized only when printed, link with -rdynamic for names.
+#ifndef RESULT_STACK_SAMPLING
+#define RESULT_STACK_SAMPLING 0
+#endif
+
+// Default sampling rate, one capture per this many err() calls.
+#ifndef RESULT_STACK_SAMPLE_RATE
+#define RESULT_STACK_SAMPLE_RATE 1024
+#endif
+
+// Preallocated traces per thread and frames per trace.
+#ifndef RESULT_STACK_POOL
+#define RESULT_STACK_POOL 16
+#endif
+
+#ifndef RESULT_STACK_DEPTH
+#define RESULT_STACK_DEPTH 32
+#endif
+
+// Explicit instantiation: build with -DRESULT_EXTERN_TEMPLATE_ENABLE=1 to make
+// the RESULT_EXTERN_* macros declare their instantiations extern (see the end
+// of this file). Off by default, as it stops the declared functions from
+// being inlined.
+#ifndef RESULT_EXTERN_TEMPLATE_ENABLE
+#define RESULT_EXTERN_TEMPLATE_ENABLE 0
+#endif
+
+// Panic policy: how every unwrap variant terminates after printing the error.
+//   RESULT_PANIC_EXIT        std::exit(1), runs atexit handlers and static destructors
+//   RESULT_PANIC_QUICK_EXIT  std::quick_exit(1), runs at_quick_exit handlers only
+//   RESULT_PANIC_FAST_EXIT   std::_Exit(1), no handlers and no stream flushing
+//   RESULT_PANIC_ABORT       std::abort(), raises SIGABRT
+//   RESULT_PANIC_TRAP        __builtin_trap(), a single trapping instruction
+//   RESULT_PANIC_HOOK        calls result_panic_hook(), defined by the user at link time
+#define RESULT_PANIC_EXIT 0
+#define RESULT_PANIC_QUICK_EXIT 1
+#define RESULT_PANIC_FAST_EXIT 2
+#define RESULT_PANIC_ABORT 3
+#define RESULT_PANIC_TRAP 4
+#define RESULT_PANIC_HOOK 5
+
+#ifndef RESULT_PANIC_POLICY
+#define RESULT_PANIC_POLICY RESULT_PANIC_EXIT
+#endif
+
+#if RESULT_TRACE_ORIGIN
+#include <source_location>
+#endif
+
+#if RESULT_TRACE_ORIGIN || RESULT_STACK_SAMPLING
+#include <atomic>
+#endif
+
+#if RESULT_STACK_SAMPLING
+#include <execinfo.h>
+#include <unwind.h>
+#endif
+
+// User supplied with RESULT_PANIC_HOOK. It must not return, but may throw
+// to abort just the current request.
+extern "C" [[noreturn]] void result_panic_hook();
+
+namespace detail {
+
+template<int Policy>
+[[noreturn]] inline auto panic() -> void {
+    if constexpr (Policy == RESULT_PANIC_QUICK_EXIT) {
+        std::quick_exit(1);
+    } else if constexpr (Policy == RESULT_PANIC_FAST_EXIT) {
+        std::_Exit(1);
+    } else if constexpr (Policy == RESULT_PANIC_ABORT) {
+        std::abort();
+    } else if constexpr (Policy == RESULT_PANIC_TRAP) {
+        __builtin_trap();
+    } else if constexpr (Policy == RESULT_PANIC_HOOK) {
+        result_panic_hook();
+    } else {
+        std::exit(1);
+    }
+}
+
+#if RESULT_TRACE_ORIGIN
+using SourceLocation = std::source_location;
+#else
+struct SourceLocation {
+    static constexpr auto current() -> SourceLocation { return {}; }
+};
+#endif
+
+// Carried alongside the error, empty unless tracking is enabled
+struct ErrorMeta {
+#if RESULT_TRACE_ORIGIN
+    std::uint32_t origin = 0;
+#endif
+#if RESULT_STACK_SAMPLING
+    std::uint32_t trace = 0;
+#endif
+};
+
+#if RESULT_TRACE_ORIGIN || RESULT_STACK_SAMPLING
+// Record ids are unique across threads: each thread takes blocks of them
+// from a shared counter. Records are looked up in the calling thread's own
+// ring, so an id handed out on another thread never matches one of them.
+inline constexpr std::uint32_t id_block = 4096;
+
+struct IdAllocator {
+    std::uint32_t next = 0;
+    std::uint32_t end = 0;
+
+    auto take(std::atomic<std::uint32_t>& blocks) -> std::uint32_t {
+        if (next == end) {
+            next = blocks.fetch_add(id_block, std::memory_order_relaxed);
+            end = next + id_block;
+        }
+        auto id = next++;
+        return id != 0 ? id : take(blocks); // 0 means no record
+    }
+};
+#endif
+
+#if RESULT_TRACE_ORIGIN
+struct OriginRecord {
+    std::source_location loc;
+    std::uint32_t id;
+    std::uint32_t parent;
+};
+
+struct OriginRing {
+    OriginRecord records[RESULT_TRACE_CAPACITY];
+    IdAllocator ids;
+};
+
+inline std::atomic<std::uint32_t> origin_ids { 0 };
+inline thread_local OriginRing origin_ring;
+
+inline auto find_origin(std::uint32_t id) -> const OriginRecord* {
+    if (id == 0) {
+        return nullptr;
+    }
+
+    auto& rec = origin_ring.records[id % RESULT_TRACE_CAPACITY];
+    return rec.id == id ? &rec : nullptr;
+}
+#endif
+
+// Record a new hop whose parent is the given meta
+inline auto record_origin([[maybe_unused]] ErrorMeta parent, [[maybe_unused]] SourceLocation loc) -> ErrorMeta {
+#if RESULT_TRACE_ORIGIN
+    auto& ring = origin_ring;
+    auto id = ring.ids.take(origin_ids);
+    ring.records[id % RESULT_TRACE_CAPACITY] = { loc, id, parent.origin };
+    parent.origin = id;
+#endif
+    return parent;
+}
+
+// Visit the recorded hops, most recent first. Stops at the first record that
+// was overwritten or recorded on another thread.
+template<typename F>
+auto visit_origin([[maybe_unused]] ErrorMeta meta, [[maybe_unused]] F&& f) -> void {
+#if RESULT_TRACE_ORIGIN
+    auto id = meta.origin;
+    for (int depth = 0; depth < RESULT_TRACE_CAPACITY; ++depth) {
+        auto rec = find_origin(id);
+        if (rec == nullptr) {
+            return;
+        }
+        f(rec->loc);
+        if (rec->parent >= id) {
+            return;
+        }
+        id = rec->parent;
+    }
+#endif
+}
+
+inline auto print_origin([[maybe_unused]] ErrorMeta meta) -> void {
+#if RESULT_TRACE_ORIGIN
+    auto first = true;
+    visit_origin(meta, [&] (const std::source_location& loc) {
+        std::fprintf(stderr, "  %s %s:%u in %s\n", first ? "at" : "from", loc.file_name(), static_cast<unsigned>(loc.line()), loc.function_name());
+        first = false;
+    });
+#endif
+}
+
+#if RESULT_STACK_SAMPLING
+struct StackTrace {
+    std::uint32_t id;
+    std::uint32_t depth;
+    void* frames[RESULT_STACK_DEPTH];
+};
+
+struct StackPool {
+    StackTrace traces[RESULT_STACK_POOL];
+    IdAllocator ids;
+    std::uint32_t tick = 0;
+};
+
+inline std::atomic<std::uint32_t> stack_sample_rate { RESULT_STACK_SAMPLE_RATE };
+inline std::atomic<std::uint32_t> stack_ids { 0 };
+inline thread_local StackPool stack_pool;
+
+inline auto find_stack(std::uint32_t id) -> const StackTrace* {
+    if (id == 0) {
+        return nullptr;
+    }
+
+    auto& trace = stack_pool.traces[id % RESULT_STACK_POOL];
+    return trace.id == id ? &trace : nullptr;
+}
+
+[[gnu::noinline, gnu::cold]] inline auto capture_stack() -> std::uint32_t {
+    auto& pool = stack_pool;
+    auto id = pool.ids.take(stack_ids);
+
+    auto& trace = pool.traces[id % RESULT_STACK_POOL];
+    trace.id = id;
+    trace.depth = 0;
+    _Unwind_Backtrace([] (_Unwind_Context* ctx, void* arg) -> _Unwind_Reason_Code {
+        auto& t = *static_cast<StackTrace*>(arg);
+        if (t.depth == RESULT_STACK_DEPTH) {
+            return _URC_END_OF_STACK;
+        }
+        if (auto ip = _Unwind_GetIP(ctx)) {
+            t.frames[t.depth++] = reinterpret_cast<void*>(ip);
+        }
+        return _URC_NO_REASON;
+    }, &trace);
+
+    return id;
+}
+#endif
+
+// Take a stack sample if this err() call is due for one
+inline auto sample_stack([[maybe_unused]] ErrorMeta meta) -> ErrorMeta {
+#if RESULT_STACK_SAMPLING
+    auto rate = stack_sample_rate.load(std::memory_order_relaxed);
+    if (rate != 0 && ++stack_pool.tick >= rate) {
+        stack_pool.tick = 0;
+        meta.trace = capture_stack();
+    }
+#endif
+    return meta;
+}
+
+inline auto print_stack([[maybe_unused]] ErrorMeta meta) -> void {
+#if RESULT_STACK_SAMPLING
+    // The first frame is capture_stack itself
+    if (auto trace = find_stack(meta.trace); trace != nullptr && trace->depth > 1) {
+        std::fprintf(stderr, "  stack:\n");
+        std::fflush(stderr);
+        backtrace_symbols_fd(const_cast<void* const*>(trace->frames) + 1, static_cast<int>(trace->depth) - 1, 2);
+    }
+#endif
+}
+
+inline auto print_meta(ErrorMeta meta) -> void {
+    print_origin(meta);
+    print_stack(meta);
+}
+
+} // namespace detail
+
 template<typename T, typename E>
 struct Result;
 
 template<typename T, typename E>
 Result<T, E> ok(T val);
 
+template<typename E>
+Result<void, E> ok();
+
+template<typename T, typename E>
+Result<T, E> err(E err, detail::SourceLocation loc = detail::SourceLocation::current());
+
+namespace detail {
+
+template<typename T, typename E>
+auto err_with_meta(E err, ErrorMeta meta) -> Result<T, E>;
+
+struct InPlaceOk {};
+struct InPlaceErr {};
+
+// The trivial special members are more constrained than the managed ones, so
+// they are the only eligible ones when both apply.
+template<typename T, typename E>
+concept CopyConstructible = std::is_copy_constructible_v<T> && std::is_copy_constructible_v<E>;
+
+template<typename T, typename E>
+concept TriviallyCopyConstructible = CopyConstructible<T, E> && std::is_trivially_copy_constructible_v<T> && std::is_trivially_copy_constructible_v<E>;
+
+// The managed assignments destroy the old state and then move the new one
+// in place, which must not throw
+template<typename T, typename E>
+concept NothrowMoveConstructible = std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_constructible_v<E>;
+
+template<typename T, typename E>
+concept TriviallyCopyAssignable = CopyConstructible<T, E> && NothrowMoveConstructible<T, E>
+    && std::is_trivially_copy_assignable_v<T> && std::is_trivially_copy_assignable_v<E>;
+
 template<typename T, typename E>
-Result<T, E> err(E err);
+concept TriviallyMoveAssignable = NothrowMoveConstructible<T, E> && std::is_trivially_move_assignable_v<T> && std::is_trivially_move_assignable_v<E>;
+
+} // namespace detail
 
 template<typename E>
 struct Display {
@@ -18,6 +334,83 @@ struct Display {
     static void print(E e);
 };
 
+// Specialize with `static constexpr auto convert(Source) -> Target` to let a
+// Result<T, Source> convert implicitly into a Result<T, Target>, replacing
+// the map_err lambda at every propagation site.
+template<typename Source, typename Target>
+struct From;
+
+namespace detail {
+
+template<typename Source, typename Target>
+concept ConvertibleError = requires(const Source& s) {
+    { From<Source, Target>::convert(s) } -> std::same_as<Target>;
+};
+
+// Not constexpr: reaching it fails constant evaluation. At run time it traps,
+// which keeps the range check in ErrorTable free of calls.
+[[noreturn]] inline auto error_table_invalid() -> void {
+    __builtin_trap();
+}
+
+} // namespace detail
+
+template<typename S, typename T>
+struct ErrorMapping {
+    S from;
+    T to;
+};
+
+// Constant error conversion table. The source values must be exactly
+// 0..N-1, each listed once, so a conversion is a range check and a single
+// array load, or just the range check when every value maps onto the same
+// number. The source enum may have values the table does not list;
+// converting one traps.
+template<typename S, typename T, std::size_t N>
+struct ErrorTable {
+    static_assert(std::is_enum_v<S> && std::is_enum_v<T>, "ErrorTable: source and target must be enums");
+
+    T to[N];
+    bool identity;
+
+    constexpr ErrorTable(const ErrorMapping<S, T> (&mappings)[N]) : to {}, identity(true) {
+        bool seen[N] = {};
+        for (auto& m : mappings) {
+            auto i = static_cast<std::size_t>(m.from);
+            if (i >= N || seen[i]) {
+                detail::error_table_invalid();
+            }
+            seen[i] = true;
+            to[i] = m.to;
+            identity = identity && static_cast<std::size_t>(m.to) == i;
+        }
+    }
+
+    constexpr auto operator()(S s) const -> T {
+        if (static_cast<std::size_t>(s) >= N) [[unlikely]] {
+            detail::error_table_invalid();
+        }
+        if (identity) {
+            return static_cast<T>(static_cast<std::underlying_type_t<T>>(s));
+        }
+        return to[static_cast<std::size_t>(s)];
+    }
+};
+
+template<typename S, typename T, std::size_t N>
+constexpr auto error_table(const ErrorMapping<S, T> (&mappings)[N]) -> ErrorTable<S, T, N> {
+    return ErrorTable<S, T, N>(mappings);
+}
+
+// Base for From specializations backed by an ErrorTable
+template<auto Table>
+struct FromTable {
+    template<typename S>
+    static constexpr auto convert(S s) -> decltype(Table(s)) {
+        return Table(s);
+    }
+};
+
 template<typename T, typename E>
 struct Result {
     using value_type = T;
@@ -33,60 +426,180 @@ struct Result {
         E error;
     };
 
+    [[no_unique_address]] detail::ErrorMeta meta;
+
+    // Special members stay trivial when T and E are, so Result of plain types
+    // is still passed in registers. Otherwise the active member is managed.
+    Result() = default;
+
+    template<typename... Args>
+    constexpr Result(detail::InPlaceOk, Args&&... args) : tag(Tag::Ok), value(std::forward<Args>(args)...), meta() {}
+
+    constexpr Result(detail::InPlaceErr, E e, detail::ErrorMeta m) : tag(Tag::Err), error(std::move(e)), meta(m) {}
+
+    // Implicit conversion through From<E2, E>
+    template<typename E2>
+    requires detail::ConvertibleError<E2, E>
+    Result(const Result<T, E2>& other, detail::SourceLocation loc = detail::SourceLocation::current()) : tag(static_cast<Tag>(other.tag)), meta() {
+        if (tag == Tag::Ok) {
+            std::construct_at(&value, other.value);
+        } else {
+            std::construct_at(&error, From<E2, E>::convert(other.error));
+            meta = detail::record_origin(other.meta, loc);
+        }
+    }
+
+    template<typename E2>
+    requires detail::ConvertibleError<E2, E>
+    Result(Result<T, E2>&& other, detail::SourceLocation loc = detail::SourceLocation::current()) : tag(static_cast<Tag>(other.tag)), meta() {
+        if (tag == Tag::Ok) {
+            std::construct_at(&value, std::move(other.value));
+        } else {
+            std::construct_at(&error, From<E2, E>::convert(other.error));
+            meta = detail::record_origin(other.meta, loc);
+        }
+    }
+
+    Result(const Result&) requires detail::TriviallyCopyConstructible<T, E> = default;
+    Result(const Result& other) requires detail::CopyConstructible<T, E> : tag(other.tag), meta(other.meta) {
+        if (tag == Tag::Ok) {
+            std::construct_at(&value, other.value);
+        } else {
+            std::construct_at(&error, other.error);
+        }
+    }
+
+    Result(Result&&) requires std::is_trivially_move_constructible_v<T> && std::is_trivially_move_constructible_v<E> = default;
+    Result(Result&& other) noexcept(detail::NothrowMoveConstructible<T, E>) : tag(other.tag), meta(other.meta) {
+        if (tag == Tag::Ok) {
+            std::construct_at(&value, std::move(other.value));
+        } else {
+            std::construct_at(&error, std::move(other.error));
+        }
+    }
+
+    auto operator=(const Result&) -> Result& requires detail::TriviallyCopyAssignable<T, E> = default;
+    // A copy that may throw is made before *this is touched
+    auto operator=(const Result& other) -> Result& requires detail::CopyConstructible<T, E> && detail::NothrowMoveConstructible<T, E> {
+        if (this != &other) {
+            if constexpr (std::is_nothrow_copy_constructible_v<T> && std::is_nothrow_copy_constructible_v<E>) {
+                destroy();
+                std::construct_at(this, other);
+            } else {
+                Result copy(other);
+                destroy();
+                std::construct_at(this, std::move(copy));
+            }
+        }
+        return *this;
+    }
+
+    auto operator=(Result&&) -> Result& requires detail::TriviallyMoveAssignable<T, E> = default;
+    auto operator=(Result&& other) noexcept -> Result& requires detail::NothrowMoveConstructible<T, E> {
+        if (this != &other) {
+            destroy();
+            std::construct_at(this, std::move(other));
+        }
+        return *this;
+    }
+
+    ~Result() requires std::is_trivially_destructible_v<T> && std::is_trivially_destructible_v<E> = default;
+    ~Result() {
+        destroy();
+    }
+
+    template<typename F>
+    auto map(F f) const& -> Result<decltype(f(std::declval<T>())), E> {
+        using U = decltype(f(std::declval<T>()));
+        if (tag == Tag::Ok) {
+            return ok<U, E>(f(value));
+        } else {
+            return detail::err_with_meta<U, E>(error, meta);
+        }
+    }
+
+    // Moves the error along instead of copying it
     template<typename F>
-    auto map(F f) const -> Result<decltype(f(std::declval<T>())), E> {
+    auto map(F f) && -> Result<decltype(f(std::declval<T>())), E> {
         using U = decltype(f(std::declval<T>()));
         if (tag == Tag::Ok) {
             return ok<U, E>(f(value));
         } else {
-            return err<U, E>(error);
+            return detail::err_with_meta<U, E>(std::move(error), meta);
         }
     }
 
     template<typename F>
-    auto map_err(F f) const -> Result<T, decltype(f(std::declval<E>()))> {
+    auto map_err(F f, detail::SourceLocation loc = detail::SourceLocation::current()) const -> Result<T, decltype(f(std::declval<E>()))> {
         static_assert(std::is_invocable_v<F, E>, "map_err: F must be callable with E");
         if (tag == Tag::Ok) {
             return ok<T, decltype(f(std::declval<E>()))>(value);
         } else {
-            return err<T, decltype(f(std::declval<E>()))>(f(error));
+            return detail::err_with_meta<T, decltype(f(std::declval<E>()))>(f(error), detail::record_origin(meta, loc));
+        }
+    }
+
+    template<typename F>
+    auto and_then(F f) & -> decltype(f(std::declval<T>())) { // You should always return a Result<T, E>
+        if (tag == Tag::Ok) {
+            return f(value);
+        } else {
+            return detail::err_with_meta<typename decltype(f(value))::value_type, E>(error, meta);
         }
     }
 
     template<typename F>
-    auto and_then(F f) -> decltype(f(std::declval<T>())) { // You should always return a Result<T, E>
+    auto and_then(F f) && -> decltype(f(std::declval<T>())) {
         if (tag == Tag::Ok) {
             return f(value);
         } else {
-            return err<typename decltype(f(value))::value_type, E>(error);
+            return detail::err_with_meta<typename decltype(f(value))::value_type, E>(std::move(error), meta);
         }
     }
     
-    auto unwrap() -> T {
+    auto unwrap() const& -> T {
         if (tag == Tag::Err) {
             Display<E>::print(error);
-            std::exit(1);
+            detail::print_meta(meta);
+            detail::panic<RESULT_PANIC_POLICY>();
         }
         
         return value;
     }
+
+    auto unwrap() && -> T {
+        if (tag == Tag::Err) {
+            Display<E>::print(error);
+            detail::print_meta(meta);
+            detail::panic<RESULT_PANIC_POLICY>();
+        }
+        
+        return std::move(value);
+    }
+
+private:
+    auto destroy() -> void {
+        if (tag == Tag::Ok) {
+            std::destroy_at(&value);
+        } else {
+            std::destroy_at(&error);
+        }
+    }
 };
 
 template<typename T, typename E>
 auto ok(T val) -> Result<T, E> {
-    return Result<T, E> { 
-        .tag = Result<T, E>::Tag::Ok,
-        .value = val
-    };
+    return Result<T, E>(detail::InPlaceOk {}, std::move(val));
 }
 
 template<typename T, typename E>
-auto err(E err) -> Result<T, E> {
-    Result<T, E> r;
-    r.tag = Result<T, E>::Tag::Err;
-    r.error = err;
+auto err(E err, detail::SourceLocation loc) -> Result<T, E> {
+    return detail::err_with_meta<T, E>(std::move(err), detail::sample_stack(detail::record_origin({}, loc)));
+}
 
-    return r;
+template<typename T, typename E>
+auto detail::err_with_meta(E err, ErrorMeta meta) -> Result<T, E> {
+    return Result<T, E>(InPlaceErr {}, std::move(err), meta);
 }
 
 template<typename T, typename E, typename OnOk, typename OnErr>
@@ -107,48 +620,61 @@ struct Result<void, E> {
         Ok, Err 
     } tag;
     E error;
+    [[no_unique_address]] detail::ErrorMeta meta;
+
+    Result() = default;
+
+    constexpr Result(detail::InPlaceOk) : tag(Tag::Ok), error(), meta() {}
+
+    constexpr Result(detail::InPlaceErr, E e, detail::ErrorMeta m) : tag(Tag::Err), error(std::move(e)), meta(m) {}
+
+    // Implicit conversion through From<E2, E>
+    template<typename E2>
+    requires detail::ConvertibleError<E2, E>
+    Result(const Result<void, E2>& other, detail::SourceLocation loc = detail::SourceLocation::current()) : tag(Tag::Ok), error(), meta() {
+        if (other.tag == Result<void, E2>::Tag::Err) {
+            tag = Tag::Err;
+            error = From<E2, E>::convert(other.error);
+            meta = detail::record_origin(other.meta, loc);
+        }
+    }
 
     template<typename F>
-    auto map_err(F f) const -> Result<void, decltype(f(std::declval<E>()))> {
+    auto map_err(F f, detail::SourceLocation loc = detail::SourceLocation::current()) const -> Result<void, decltype(f(std::declval<E>()))> {
         static_assert(std::is_invocable_v<F, E>, "map_err: F must be callable with E");
         if (tag == Tag::Err) {
-            return err<void, decltype(f(std::declval<E>()))>(f(error));
+            return detail::err_with_meta<void, decltype(f(std::declval<E>()))>(f(error), detail::record_origin(meta, loc));
         }
 
-        return ok<void, decltype(f(std::declval<E>()))>();
+        return ok<decltype(f(std::declval<E>()))>();
     }
 
     auto unwrap() -> void {
         if (tag == Tag::Err) {
             Display<E>::print(error);
-            std::exit(1);
+            detail::print_meta(meta);
+            detail::panic<RESULT_PANIC_POLICY>();
         }
     }
 };
 
 template<typename E>
 auto ok() -> Result<void, E> {
-    return Result<void, E> { 
-        Result<void, E>::Tag::Ok, 
-        {} 
-    };
+    return Result<void, E>(detail::InPlaceOk {});
 }
 
 template<typename E>
-auto err(E err) -> Result<void, E> {
-    return Result<void, E> {
-        Result<void, E>::Tag::Err,
-        err
-    };
+auto err(E err, detail::SourceLocation loc = detail::SourceLocation::current()) -> Result<void, E> {
+    return detail::err_with_meta<void, E>(std::move(err), detail::sample_stack(detail::record_origin({}, loc)));
 }
 
 template<typename Ptr, typename Error>
-auto ok_or(Ptr ptr, Error e) -> Result<decltype(ptr), Error> {
+auto ok_or(Ptr ptr, Error e, detail::SourceLocation loc = detail::SourceLocation::current()) -> Result<decltype(ptr), Error> {
     if (ptr != nullptr) {
         return ok<decltype(ptr), Error>(ptr);
     }
 
-    return err<decltype(ptr), Error>(e);
+    return err<decltype(ptr), Error>(e, loc);
 }
 
 // Fatal: print error and exit
@@ -156,18 +682,33 @@ template<typename T, typename E>
 T unwrap(const Result<T, E>& res) {
     if (res.tag == Result<T, E>::Tag::Err) {
         Display<E>::print(res.error);
-        std::exit(1);
+        detail::print_meta(res.meta);
+        detail::panic<RESULT_PANIC_POLICY>();
     }
 
     return res.value;
 }
 
+// Fatal, moving the value out of a temporary
+template<typename T, typename E>
+requires (!std::is_void_v<T>)
+T unwrap(Result<T, E>&& res) {
+    if (res.tag == Result<T, E>::Tag::Err) {
+        Display<E>::print(res.error);
+        detail::print_meta(res.meta);
+        detail::panic<RESULT_PANIC_POLICY>();
+    }
+
+    return std::move(res.value);
+}
+
 // Specialization for void: fatal, no return value
 template<typename E>
 void unwrap(const Result<void, E>& res) {
     if (res.tag == Result<void, E>::Tag::Err) {
         Display<E>::print(res.error);
-        std::exit(1);
+        detail::print_meta(res.meta);
+        detail::panic<RESULT_PANIC_POLICY>();
     }
 }
 
@@ -201,3 +742,120 @@ auto unwrap_or_else(const Result<void, E>& res, F on_error) -> void {
     }
 }
 
+// Debug: visit the origin trail of an error, most recent hop first.
+// Only produces locations when built with RESULT_TRACE_ORIGIN.
+template<typename T, typename E, typename F>
+auto visit_trail(const Result<T, E>& res, F&& f) -> void {
+    if (res.tag == Result<T, E>::Tag::Err) {
+        detail::visit_origin(res.meta, std::forward<F>(f));
+    }
+}
+
+// Debug: print the origin trail of an error to stderr
+template<typename T, typename E>
+auto print_trail(const Result<T, E>& res) -> void {
+    if (res.tag == Result<T, E>::Tag::Err) {
+        detail::print_origin(res.meta);
+    }
+}
+
+// Capture a stack on one in every n err() calls, 0 disables sampling.
+// Only has an effect when built with RESULT_STACK_SAMPLING.
+inline auto set_stack_sample_rate([[maybe_unused]] std::uint32_t n) -> void {
+#if RESULT_STACK_SAMPLING
+    detail::stack_sample_rate.store(n, std::memory_order_relaxed);
+#endif
+}
+
+// Debug: true if a stack was sampled when this error was created
+template<typename T, typename E>
+auto has_stack([[maybe_unused]] const Result<T, E>& res) -> bool {
+#if RESULT_STACK_SAMPLING
+    return res.tag == Result<T, E>::Tag::Err && detail::find_stack(res.meta.trace) != nullptr;
+#else
+    return false;
+#endif
+}
+
+// Debug: symbolize and print the sampled stack of an error to stderr
+template<typename T, typename E>
+auto print_stack(const Result<T, E>& res) -> void {
+    if (res.tag == Result<T, E>::Tag::Err) {
+        detail::print_stack(res.meta);
+    }
+}
+
+// Explicit instantiation of Result<T, E> and its non-lambda free functions,
+// to compile them once instead of in every TU. Declare the pairs a project
+// uses everywhere next to the error types, and define them in one TU:
+//
+//   RESULT_EXTERN_TEMPLATE(int, ParseError);  // errors.hpp
+//   RESULT_INSTANTIATE(int, ParseError);      // errors.cpp
+//
+// map, map_err and and_then are instantiated per callable. A lambda's type
+// is local to its TU, but a named function object shared through a header
+// can be instantiated once like the rest:
+//
+//   struct Doubled { auto operator()(int v) const -> int { return v * 2; } };
+//   RESULT_EXTERN_MAP(int, ParseError, Doubled);      // errors.hpp
+//   RESULT_INSTANTIATE_MAP(int, ParseError, Doubled); // errors.cpp
+//
+// Types containing commas need an alias first. Use the _VOID variants for
+// Result<void, E>; the monadic macros cover Result<T, E> with a value only.
+//
+// The RESULT_EXTERN_* macros expand to nothing unless
+// RESULT_EXTERN_TEMPLATE_ENABLE is set, and RESULT_INSTANTIATE_* always
+// instantiate. The compiler does not inline a function declared extern
+// unless it is inline itself, so with optimization ok, err, unwrap and the
+// declared callables become calls. That can cost more code and compile time
+// than instantiating them in every TU; measure before enabling it in
+// optimized builds.
+#define RESULT_DETAIL_INSTANTIATIONS(EXTERN, T, E) \
+    EXTERN template struct Result<T, E>; \
+    EXTERN template auto ok<T, E>(T) -> Result<T, E>; \
+    EXTERN template auto err<T, E>(E, detail::SourceLocation) -> Result<T, E>; \
+    EXTERN template auto detail::err_with_meta<T, E>(E, detail::ErrorMeta) -> Result<T, E>; \
+    EXTERN template T unwrap<T, E>(const Result<T, E>&); \
+    EXTERN template T unwrap<T, E>(Result<T, E>&&); \
+    EXTERN template T unwrap_or<T, E>(const Result<T, E>&, T); \
+    EXTERN template auto print_trail<T, E>(const Result<T, E>&) -> void; \
+    EXTERN template auto print_stack<T, E>(const Result<T, E>&) -> void
+
+#define RESULT_DETAIL_INSTANTIATIONS_VOID(EXTERN, E) \
+    EXTERN template struct Result<void, E>; \
+    EXTERN template auto ok<E>() -> Result<void, E>; \
+    EXTERN template auto err<E>(E, detail::SourceLocation) -> Result<void, E>; \
+    EXTERN template auto detail::err_with_meta<void, E>(E, detail::ErrorMeta) -> Result<void, E>; \
+    EXTERN template void unwrap<E>(const Result<void, E>&); \
+    EXTERN template auto print_trail<void, E>(const Result<void, E>&) -> void; \
+    EXTERN template auto print_stack<void, E>(const Result<void, E>&) -> void
+
+#define RESULT_DETAIL_MAP(EXTERN, T, E, F) \
+    EXTERN template auto Result<T, E>::map<F>(F) const& -> Result<std::invoke_result_t<F, T>, E>; \
+    EXTERN template auto Result<T, E>::map<F>(F) && -> Result<std::invoke_result_t<F, T>, E>
+
+#define RESULT_DETAIL_MAP_ERR(EXTERN, T, E, F) \
+    EXTERN template auto Result<T, E>::map_err<F>(F, detail::SourceLocation) const -> Result<T, std::invoke_result_t<F, E>>
+
+#define RESULT_DETAIL_AND_THEN(EXTERN, T, E, F) \
+    EXTERN template auto Result<T, E>::and_then<F>(F) & -> std::invoke_result_t<F, T>; \
+    EXTERN template auto Result<T, E>::and_then<F>(F) && -> std::invoke_result_t<F, T>
+
+#if RESULT_EXTERN_TEMPLATE_ENABLE
+#define RESULT_EXTERN_TEMPLATE(T, E) RESULT_DETAIL_INSTANTIATIONS(extern, T, E)
+#define RESULT_EXTERN_TEMPLATE_VOID(E) RESULT_DETAIL_INSTANTIATIONS_VOID(extern, E)
+#define RESULT_EXTERN_MAP(T, E, F) RESULT_DETAIL_MAP(extern, T, E, F)
+#define RESULT_EXTERN_MAP_ERR(T, E, F) RESULT_DETAIL_MAP_ERR(extern, T, E, F)
+#define RESULT_EXTERN_AND_THEN(T, E, F) RESULT_DETAIL_AND_THEN(extern, T, E, F)
+#else
+#define RESULT_EXTERN_TEMPLATE(T, E) static_assert(true)
+#define RESULT_EXTERN_TEMPLATE_VOID(E) static_assert(true)
+#define RESULT_EXTERN_MAP(T, E, F) static_assert(true)
+#define RESULT_EXTERN_MAP_ERR(T, E, F) static_assert(true)
+#define RESULT_EXTERN_AND_THEN(T, E, F) static_assert(true)
+#endif
+#define RESULT_INSTANTIATE(T, E) RESULT_DETAIL_INSTANTIATIONS(, T, E)
+#define RESULT_INSTANTIATE_VOID(E) RESULT_DETAIL_INSTANTIATIONS_VOID(, E)
+#define RESULT_INSTANTIATE_MAP(T, E, F) RESULT_DETAIL_MAP(, T, E, F)
+#define RESULT_INSTANTIATE_MAP_ERR(T, E, F) RESULT_DETAIL_MAP_ERR(, T, E, F)
+#define RESULT_INSTANTIATE_AND_THEN(T, E, F) RESULT_DETAIL_AND_THEN(, T, E, F)
@@ -0,0 +1,308 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+#include "result.hpp"
+
+// Bounded lock-free queues of Result<T, E> between pipeline stages:
+// SpscQueue for one producer and one consumer, MpmcQueue for any number of
+// each. The capacity is rounded up to a power of two, and the producer and
+// consumer indices sit on separate cache lines.
+//
+// A stage that fails as a whole calls close(error). Consumers drain what is
+// already queued and then receive that terminal error from pop(), which
+// returns Result<Result<T, E>, E>: Ok holds the next item, Err the error the
+// queue was closed with.
+//
+//   MpmcQueue<Row, LoadError> rows(1024);
+//   rows.push(parse_row(line));            // producers, Ok or a per-row error
+//   rows.close(LoadError::Disconnected);   // the source failed
+//
+//   for (auto next = rows.pop(); next.tag == decltype(next)::Tag::Ok; next = rows.pop()) {
+//       handle(std::move(next.value));     // Result<Row, LoadError>
+//   }
+//
+// Pushes that race with close() may or may not be delivered; close after
+// the producers are done when every item matters.
+
+namespace detail {
+
+inline constexpr std::size_t cache_line = 64;
+
+inline auto queue_capacity(std::size_t n) -> std::size_t {
+    std::size_t cap = 2;
+    while (cap < n) {
+        cap *= 2;
+    }
+    return cap;
+}
+
+// Spins briefly, then yields so that waiting threads do not starve the ones
+// they wait for when there are more threads than cores
+struct Backoff {
+    unsigned spins = 0;
+
+    auto wait() -> void {
+        if (spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+            ++spins;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+};
+
+// Uninitialized room for one Result<T, E>
+template<typename T, typename E>
+struct ResultStorage {
+    alignas(Result<T, E>) std::byte bytes[sizeof(Result<T, E>)];
+
+    auto get() -> Result<T, E>* {
+        return std::launder(reinterpret_cast<Result<T, E>*>(bytes));
+    }
+};
+
+// The terminal error shared by both queues. The first close() wins.
+template<typename E>
+class QueueClose {
+public:
+    auto close(E e) -> bool {
+        int expected = Open;
+        if (!state.compare_exchange_strong(expected, Closing, std::memory_order_acq_rel)) {
+            return false;
+        }
+        ::new (&error.bytes) E(std::move(e));
+        state.store(Closed, std::memory_order_release);
+        return true;
+    }
+
+    auto closed() const -> bool {
+        return state.load(std::memory_order_acquire) != Open;
+    }
+
+protected:
+    ~QueueClose() {
+        if (state.load(std::memory_order_relaxed) == Closed) {
+            terminal().~E();
+        }
+    }
+
+    // Only once closed() and the close has finished publishing
+    auto terminal_ready() const -> bool {
+        return state.load(std::memory_order_acquire) == Closed;
+    }
+
+    auto terminal() -> E& {
+        return *std::launder(reinterpret_cast<E*>(error.bytes));
+    }
+
+    // Blocks until an item or the terminal error is available
+    template<typename T, typename Queue>
+    auto pop_or_terminal(Queue& q) -> Result<Result<T, E>, E> {
+        Backoff backoff;
+        for (;;) {
+            if (auto item = q.try_pop()) {
+                return ok<Result<T, E>, E>(std::move(*item));
+            }
+            if (terminal_ready()) {
+                // Items published before the close are still delivered first
+                if (auto item = q.try_pop()) {
+                    return ok<Result<T, E>, E>(std::move(*item));
+                }
+                return err<Result<T, E>, E>(terminal());
+            }
+            backoff.wait();
+        }
+    }
+
+    template<typename Queue, typename Item>
+    auto push_until_closed(Queue& q, Item&& item) -> bool {
+        Backoff backoff;
+        while (!closed()) {
+            if (q.try_push(std::forward<Item>(item))) {
+                return true;
+            }
+            backoff.wait();
+        }
+        return false;
+    }
+
+private:
+    enum : int { Open, Closing, Closed };
+
+    std::atomic<int> state { Open };
+    struct {
+        alignas(E) std::byte bytes[sizeof(E)];
+    } error;
+};
+
+} // namespace detail
+
+template<typename T, typename E>
+class SpscQueue : public detail::QueueClose<E> {
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : mask(detail::queue_capacity(capacity) - 1), slots(std::make_unique<detail::ResultStorage<T, E>[]>(mask + 1)) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    auto operator=(const SpscQueue&) -> SpscQueue& = delete;
+
+    ~SpscQueue() {
+        while (try_pop()) {}
+    }
+
+    // False when the queue is full or closed; item is then left untouched
+    auto try_push(Result<T, E>&& item) -> bool {
+        auto t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head > mask) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask) {
+                return false;
+            }
+        }
+        if (this->closed()) {
+            return false;
+        }
+        ::new (slots[t & mask].bytes) Result<T, E>(std::move(item));
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Waits for room; false when the queue was closed first
+    auto push(Result<T, E> item) -> bool {
+        return this->push_until_closed(*this, std::move(item));
+    }
+
+    auto try_pop() -> std::optional<Result<T, E>> {
+        auto h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) {
+                return std::nullopt;
+            }
+        }
+        auto slot = slots[h & mask].get();
+        std::optional<Result<T, E>> item(std::move(*slot));
+        slot->~Result<T, E>();
+        head.store(h + 1, std::memory_order_release);
+        return item;
+    }
+
+    auto pop() -> Result<Result<T, E>, E> {
+        return this->template pop_or_terminal<T>(*this);
+    }
+
+    auto capacity() const -> std::size_t {
+        return mask + 1;
+    }
+
+private:
+    std::size_t mask;
+    std::unique_ptr<detail::ResultStorage<T, E>[]> slots;
+
+    // Consumer side
+    alignas(detail::cache_line) std::atomic<std::size_t> head { 0 };
+    std::size_t cached_tail = 0;
+
+    // Producer side
+    alignas(detail::cache_line) std::atomic<std::size_t> tail { 0 };
+    std::size_t cached_head = 0;
+};
+
+// Bounded MPMC queue after Dmitry Vyukov's design: each cell carries a
+// sequence number that says whether it is ready for the next producer or
+// the next consumer, so a push or pop is one CAS on its index.
+template<typename T, typename E>
+class MpmcQueue : public detail::QueueClose<E> {
+public:
+    explicit MpmcQueue(std::size_t capacity)
+        : mask(detail::queue_capacity(capacity) - 1), cells(std::make_unique<Cell[]>(mask + 1)) {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    auto operator=(const MpmcQueue&) -> MpmcQueue& = delete;
+
+    ~MpmcQueue() {
+        while (try_pop()) {}
+    }
+
+    // False when the queue is full or closed; item is then left untouched
+    auto try_push(Result<T, E>&& item) -> bool {
+        if (this->closed()) {
+            return false;
+        }
+        auto pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& cell = cells[pos & mask];
+            auto seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    ::new (cell.storage.bytes) Result<T, E>(std::move(item));
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Waits for room; false when the queue was closed first
+    auto push(Result<T, E> item) -> bool {
+        return this->push_until_closed(*this, std::move(item));
+    }
+
+    auto try_pop() -> std::optional<Result<T, E>> {
+        auto pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& cell = cells[pos & mask];
+            auto seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    auto slot = cell.storage.get();
+                    std::optional<Result<T, E>> item(std::move(*slot));
+                    slot->~Result<T, E>();
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return item;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    auto pop() -> Result<Result<T, E>, E> {
+        return this->template pop_or_terminal<T>(*this);
+    }
+
+    auto capacity() const -> std::size_t {
+        return mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        detail::ResultStorage<T, E> storage;
+    };
+
+    std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(detail::cache_line) std::atomic<std::size_t> tail { 0 };
+    alignas(detail::cache_line) std::atomic<std::size_t> head { 0 };
+};
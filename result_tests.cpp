@@ -1,8 +1,39 @@
 #include "catch2/catch_test_macros.hpp"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
 #include <type_traits>
+#include <unistd.h>
+#include <vector>
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch_all.hpp>
+#ifndef RESULT_EXTERN_TEMPLATE_ENABLE
+#define RESULT_EXTERN_TEMPLATE_ENABLE 1  // exercise the extern declarations below
+#endif
 #include "result.hpp"  // include the implementation file directly for testing
+#include "boxed.hpp"
+#include "context.hpp"
+#include "dyn_error.hpp"
+#include "error_code.hpp"
+#include "error_sink.hpp"
+#include "io_ring.hpp"
+#include "batch_parse.hpp"
+#include "mapped_file.hpp"
+#include "memoize.hpp"
+#include "message.hpp"
+#include "parse.hpp"
+#include "record_reader.hpp"
+#include "result_queue.hpp"
+#include "sys.hpp"
+#include "validated.hpp"
 
 // Define a test error enum to use with Result
 enum class TestError {
@@ -30,6 +61,52 @@ struct Display<RootError> {
     }
 };
 
+// The most used pairs go through the explicit instantiation macros, as a
+// project would split them between a shared header and one TU
+RESULT_EXTERN_TEMPLATE(int, TestError);
+RESULT_EXTERN_TEMPLATE_VOID(TestError);
+RESULT_INSTANTIATE(int, TestError);
+RESULT_INSTANTIATE_VOID(TestError);
+
+struct Doubled {
+    auto operator()(int v) const -> int {
+        return v * 2;
+    }
+};
+
+struct Positive {
+    auto operator()(int v) const -> Result<int, TestError> {
+        if (v <= 0) {
+            return err<int, TestError>(TestError::B);
+        }
+        return ok<int, TestError>(v);
+    }
+};
+
+struct ToRoot {
+    auto operator()(TestError e) const -> RootError {
+        return e == TestError::A ? RootError::C : RootError::D;
+    }
+};
+
+RESULT_EXTERN_MAP(int, TestError, Doubled);
+RESULT_EXTERN_AND_THEN(int, TestError, Positive);
+RESULT_EXTERN_MAP_ERR(int, TestError, ToRoot);
+RESULT_INSTANTIATE_MAP(int, TestError, Doubled);
+RESULT_INSTANTIATE_AND_THEN(int, TestError, Positive);
+RESULT_INSTANTIATE_MAP_ERR(int, TestError, ToRoot);
+
+TEST_CASE("named function objects go through the monadic instantiation macros", "Result") {
+    auto r = ok<int, TestError>(3);
+    REQUIRE(r.map(Doubled {}).value == 6);
+    REQUIRE(std::move(r).map(Doubled {}).value == 6);
+    REQUIRE(ok<int, TestError>(1).and_then(Positive {}).value == 1);
+
+    auto failed = ok<int, TestError>(0).and_then(Positive {});
+    REQUIRE(failed.error == TestError::B);
+    REQUIRE(failed.map_err(ToRoot {}).error == RootError::D);
+}
+
 TEST_CASE("ok and err basic behavior", "Result") {
     SECTION("ok holds value") {
         auto r = ok<int, TestError>(123);
@@ -175,3 +252,1396 @@ TEST_CASE("match operator for result") {
     REQUIRE(val_ok == false);
     REQUIRE(val_err == true);
 }
+
+TEST_CASE("origin tracking does not change layout", "trail") {
+#if !RESULT_TRACE_ORIGIN && !RESULT_STACK_SAMPLING
+    STATIC_REQUIRE(sizeof(Result<int, TestError>) == 2 * sizeof(int));
+    STATIC_REQUIRE(sizeof(Result<void, TestError>) == 2 * sizeof(int));
+#endif
+    auto lines = 0;
+    visit_trail(ok<int, TestError>(1), [&] (auto) { ++lines; });
+    REQUIRE(lines == 0);
+}
+
+#if RESULT_TRACE_ORIGIN
+TEST_CASE("trail records err and map_err hops", "trail") {
+    auto created = std::source_location::current().line() + 1;
+    auto r = err<int, TestError>(TestError::A)
+        .map_err([] (TestError) { return RootError::C; });
+
+    std::vector<unsigned> lines;
+    visit_trail(r, [&] (const std::source_location& loc) { lines.push_back(loc.line()); });
+    REQUIRE(lines.size() == 2);
+    REQUIRE(lines[0] == created + 1);
+    REQUIRE(lines[1] == created);
+}
+
+TEST_CASE("trail survives map and and_then", "trail") {
+    auto r = err<int, TestError>(TestError::B)
+        .map([] (int i) { return static_cast<char>(i); })
+        .and_then([] (char c) { return ok<int, TestError>(c); });
+
+    auto hops = 0;
+    visit_trail(r, [&] (const std::source_location&) { ++hops; });
+    REQUIRE(hops == 1);
+}
+
+TEST_CASE("trail stops when the ring wrapped", "trail") {
+    auto r = err<void, TestError>(TestError::A);
+    for (int i = 0; i < RESULT_TRACE_CAPACITY; ++i) {
+        (void)err<int, TestError>(TestError::B);
+    }
+
+    auto hops = 0;
+    visit_trail(r, [&] (const std::source_location&) { ++hops; });
+    REQUIRE(hops == 0);
+}
+
+TEST_CASE("trail of an error from another thread is truncated", "trail") {
+    // Records of this thread whose ids a per-thread counter would reuse
+    for (int i = 0; i < 8; ++i) {
+        (void)err<int, TestError>(TestError::B);
+    }
+
+    auto r = ok<int, TestError>(0);
+    std::thread([&] { r = err<int, TestError>(TestError::A); }).join();
+
+    auto hops = 0;
+    visit_trail(r, [&] (const std::source_location&) { ++hops; });
+    REQUIRE(hops == 0);
+}
+#endif
+
+#if RESULT_STACK_SAMPLING
+TEST_CASE("stack is sampled at the configured rate", "stack") {
+    set_stack_sample_rate(1);
+    REQUIRE(has_stack(err<int, TestError>(TestError::A)));
+
+    set_stack_sample_rate(0);
+    REQUIRE_FALSE(has_stack(err<int, TestError>(TestError::A)));
+
+    set_stack_sample_rate(4);
+    auto sampled = 0;
+    for (int i = 0; i < 16; ++i) {
+        sampled += has_stack(err<void, TestError>(TestError::B)) ? 1 : 0;
+    }
+    REQUIRE(sampled == 4);
+
+    set_stack_sample_rate(RESULT_STACK_SAMPLE_RATE);
+}
+
+TEST_CASE("stack sampled on another thread is not found", "stack") {
+    set_stack_sample_rate(1);
+    for (int i = 0; i < 4; ++i) {
+        (void)err<int, TestError>(TestError::B);
+    }
+
+    auto r = ok<int, TestError>(0);
+    std::thread([&] { r = err<int, TestError>(TestError::A); }).join();
+    REQUIRE_FALSE(has_stack(r));
+    set_stack_sample_rate(RESULT_STACK_SAMPLE_RATE);
+}
+
+TEST_CASE("sampled stack survives map_err", "stack") {
+    set_stack_sample_rate(1);
+    auto r = err<int, TestError>(TestError::A).map_err([] (TestError) { return RootError::D; });
+    REQUIRE(has_stack(r));
+    set_stack_sample_rate(RESULT_STACK_SAMPLE_RATE);
+}
+#endif
+
+// Run f in a forked child and return its wait status
+template<typename F>
+static auto child_status(F f) -> int {
+    auto pid = fork();
+    if (pid == 0) {
+        rlimit no_core { 0, 0 };
+        setrlimit(RLIMIT_CORE, &no_core);
+        f();
+        std::_Exit(0);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return status;
+}
+
+TEST_CASE("failing unwrap terminates through the panic policy", "panic") {
+    auto status = child_status([] { (void)unwrap(err<int, TestError>(TestError::A)); });
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 1);
+
+    status = child_status([] { err<void, TestError>(TestError::B).unwrap(); });
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 1);
+
+    status = child_status([] { (void)ok<int, TestError>(1).unwrap(); });
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+}
+
+TEST_CASE("panic policies", "panic") {
+    auto status = child_status([] { detail::panic<RESULT_PANIC_QUICK_EXIT>(); });
+    REQUIRE((WIFEXITED(status) && WEXITSTATUS(status) == 1));
+
+    status = child_status([] { detail::panic<RESULT_PANIC_FAST_EXIT>(); });
+    REQUIRE((WIFEXITED(status) && WEXITSTATUS(status) == 1));
+
+    status = child_status([] { detail::panic<RESULT_PANIC_ABORT>(); });
+    REQUIRE((WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT));
+
+    status = child_status([] { detail::panic<RESULT_PANIC_TRAP>(); });
+    REQUIRE(WIFSIGNALED(status));
+}
+
+TEST_CASE("Result manages non-trivial values and errors", "Result") {
+    auto r = ok<std::string, TestError>(std::string(64, 'x'));
+    auto copy = r;
+    REQUIRE(copy.value == r.value);
+
+    auto moved = std::move(copy);
+    REQUIRE(moved.value.size() == 64);
+
+    moved = err<std::string, TestError>(TestError::B);
+    REQUIRE(moved.tag == Result<std::string, TestError>::Tag::Err);
+    REQUIRE(moved.error == TestError::B);
+
+    moved = r;
+    REQUIRE(moved.tag == Result<std::string, TestError>::Tag::Ok);
+    REQUIRE(unwrap(std::move(moved)).size() == 64);
+
+    STATIC_REQUIRE(std::is_trivially_copyable_v<Result<int, TestError>>);
+    STATIC_REQUIRE_FALSE(std::is_trivially_copyable_v<Result<std::string, TestError>>);
+}
+
+struct LargeError {
+    int code;
+    char context[120];
+};
+
+template<>
+struct Display<LargeError> {
+    static void print(const LargeError&) {
+        // no-op for tests
+    }
+};
+
+TEST_CASE("Boxed keeps large errors out of line", "Boxed") {
+    STATIC_REQUIRE(sizeof(Result<int, LargeError>) > sizeof(LargeError));
+#if !RESULT_TRACE_ORIGIN && !RESULT_STACK_SAMPLING
+    STATIC_REQUIRE(sizeof(Result<int, Boxed<LargeError>>) == 2 * sizeof(void*));
+#endif
+
+    auto r = err<int, Boxed<LargeError>>(LargeError { 7, "context" });
+    REQUIRE(r.tag == Result<int, Boxed<LargeError>>::Tag::Err);
+    REQUIRE(r.error->code == 7);
+
+    auto copy = r;
+    REQUIRE(&*copy.error != &*r.error);
+    REQUIRE(copy.error->code == 7);
+
+    auto code = r.map([] (int i) { return i + 1; })
+        .map_err([] (const Boxed<LargeError>& e) { return e->code; });
+    REQUIRE(code.error == 7);
+
+    auto ok_r = ok<int, Boxed<LargeError>>(3);
+    REQUIRE(unwrap(ok_r) == 3);
+}
+
+TEST_CASE("Boxed reuses pool blocks", "Boxed") {
+    const LargeError* first = nullptr;
+    {
+        Boxed<LargeError> b(LargeError { 1, "" });
+        first = &*b;
+    }
+    Boxed<LargeError> again(LargeError { 2, "" });
+    REQUIRE(&*again == first);
+}
+
+TEST_CASE("Boxed error moves through map and and_then", "Boxed") {
+    auto r = err<int, Boxed<LargeError>>(LargeError { 3, "" });
+    auto box = &*r.error;
+    auto moved = std::move(r)
+        .map([] (int i) { return i + 1; })
+        .and_then([] (int i) { return ok<int, Boxed<LargeError>>(i); });
+    REQUIRE(&*moved.error == box);
+}
+
+TEST_CASE("Boxed blocks released on another thread are reused", "Boxed") {
+    using Pool = detail::BoxPool<sizeof(LargeError), alignof(LargeError)>;
+    std::vector<Boxed<LargeError>> boxes;
+    std::thread([&] {
+        for (int i = 0; i < 1000; ++i) {
+            boxes.emplace_back(LargeError { i, "" });
+        }
+    }).join();
+
+    std::vector<const LargeError*> released;
+    for (auto& b : boxes) {
+        released.push_back(&*b);
+    }
+    boxes.clear();
+    REQUIRE(Pool::cache.count <= Pool::cache_limit);
+
+    // The surplus went to the shared list, where a new thread finds it
+    const LargeError* taken = nullptr;
+    std::thread([&] {
+        Boxed<LargeError> b(LargeError { 0, "" });
+        taken = &*b;
+    }).join();
+    REQUIRE(std::find(released.begin(), released.end(), taken) != released.end());
+}
+
+// Made before the thread's first box, so destroyed after its pool cache
+struct LateBox {
+    std::optional<Boxed<LargeError>> box;
+
+    ~LateBox() {
+        box.reset();
+        Boxed<LargeError> again(LargeError { 2, "" });
+    }
+};
+
+TEST_CASE("Boxed released from a thread_local destructor goes to the shared list", "Boxed") {
+    using Pool = detail::BoxPool<sizeof(LargeError), alignof(LargeError)>;
+    const LargeError* late = nullptr;
+    std::thread([&] {
+        static thread_local LateBox holder;
+        holder.box.emplace(LargeError { 1, "" });
+        late = &**holder.box;
+        Boxed<LargeError> b(LargeError { 0, "" });
+    }).join();
+
+    // Every block is on exactly one free list
+    auto& shared = Pool::shared();
+    std::lock_guard lock(shared.mutex);
+    std::vector<const void*> blocks;
+    for (auto& batch : shared.batches) {
+        std::size_t n = 0;
+        for (auto block = batch.head; block != nullptr; block = block->next, ++n) {
+            blocks.push_back(block);
+        }
+        REQUIRE(n == batch.count);
+    }
+    std::sort(blocks.begin(), blocks.end());
+    REQUIRE(std::adjacent_find(blocks.begin(), blocks.end()) == blocks.end());
+    REQUIRE(std::binary_search(blocks.begin(), blocks.end(), static_cast<const void*>(late)));
+}
+
+struct ThrowingError {
+    static inline bool fail = false;
+
+    int code;
+    char context[60];
+
+    ThrowingError(int code) : code(code), context {} {}
+
+    ThrowingError(const ThrowingError& other) : code(other.code), context {} {
+        if (fail) {
+            throw std::runtime_error("copy");
+        }
+    }
+
+    ThrowingError(ThrowingError&& other) noexcept : code(other.code), context {} {}
+
+    auto operator=(const ThrowingError& other) -> ThrowingError& {
+        code = other.code;
+        return *this;
+    }
+};
+
+template<>
+struct Display<ThrowingError> {
+    static void print(const ThrowingError&) {}
+};
+
+struct ThrowingMove {
+    ThrowingMove() = default;
+    ThrowingMove(const ThrowingMove&) = default;
+    ThrowingMove(ThrowingMove&&) noexcept(false) {}
+    std::string text;
+};
+
+TEST_CASE("a throwing copy leaves the assigned Result as it was", "Result") {
+    auto target = err<int, ThrowingError>(ThrowingError(1));
+    auto source = err<int, ThrowingError>(ThrowingError(2));
+    ThrowingError::fail = true;
+    REQUIRE_THROWS(target = source);
+    ThrowingError::fail = false;
+    REQUIRE(target.error.code == 1);
+
+    STATIC_REQUIRE(std::is_nothrow_move_assignable_v<Result<std::string, ThrowingError>>);
+    STATIC_REQUIRE_FALSE(std::is_copy_assignable_v<Result<ThrowingMove, TestError>>);
+    STATIC_REQUIRE_FALSE(std::is_move_assignable_v<Result<ThrowingMove, TestError>>);
+}
+
+TEST_CASE("Boxed returns its block when the error's constructor throws", "Boxed") {
+    Boxed<ThrowingError> source(ThrowingError(2));
+    const ThrowingError* first = nullptr;
+    {
+        Boxed<ThrowingError> b(ThrowingError(1));
+        first = &*b;
+    }
+    ThrowingError::fail = true;
+    REQUIRE_THROWS(Boxed<ThrowingError>(source));
+    ThrowingError::fail = false;
+
+    Boxed<ThrowingError> again(ThrowingError(3));
+    REQUIRE(&*again == first);
+}
+
+TEST_CASE("wrap_err keeps the original error as cause", "Chain") {
+    ArenaScope scope;
+    auto r = wrap_err(err<int, TestError>(TestError::B), [] (TestError) { return RootError::C; }, "converting");
+    REQUIRE(r.tag == Result<int, Chain<RootError>>::Tag::Err);
+    REQUIRE(r.error.error == RootError::C);
+
+    std::vector<const detail::ContextFrame*> frames;
+    r.error.for_each_frame([&] (const detail::ContextFrame& f) { frames.push_back(&f); });
+    REQUIRE(frames.size() == 1);
+    REQUIRE(std::string(frames[0]->message) == "converting");
+    REQUIRE(*static_cast<const TestError*>(frames[0]->error) == TestError::B);
+
+    auto ok_r = wrap_err(ok<int, TestError>(1), [] (TestError) { return RootError::C; });
+    REQUIRE(unwrap(ok_r) == 1);
+}
+
+TEST_CASE("context and wrap_err extend an existing chain", "Chain") {
+    ArenaScope scope;
+    auto inner = wrap_err(err<int, TestError>(TestError::A), [] (TestError) { return RootError::D; });
+    auto outer = context(inner, "loading");
+    auto converted = wrap_err(outer, [] (RootError) { return TestError::B; });
+
+    std::vector<std::string> messages;
+    auto causes = 0;
+    converted.error.for_each_frame([&] (const detail::ContextFrame& f) {
+        messages.push_back(f.message ? f.message : "");
+        causes += f.error != nullptr;
+    });
+    REQUIRE(messages == std::vector<std::string> { "", "loading", "" });
+    REQUIRE(causes == 2);
+    REQUIRE(converted.error.error == TestError::B);
+}
+
+TEST_CASE("ArenaScope releases frames in bulk", "Chain") {
+    auto& arena = ErrorArena::current();
+    auto before = arena.mark();
+    {
+        ArenaScope scope;
+        for (int i = 0; i < 10000; ++i) {
+            (void)context(err<void, TestError>(TestError::A), "frame");
+        }
+    }
+    auto after = arena.mark();
+    REQUIRE(after.chunk == before.chunk);
+    REQUIRE(after.used == before.used);
+}
+
+RESULT_ERROR_CATEGORY(TestError, 1, "test");
+RESULT_ERROR_CATEGORY(RootError, 2, "root");
+
+TEST_CASE("ErrorCode packs category, code and payload", "ErrorCode") {
+    constexpr ErrorCode e(RootError::D, 1234);
+    STATIC_REQUIRE(e.category() == 2);
+    STATIC_REQUIRE(e.code() == static_cast<std::uint16_t>(RootError::D));
+    STATIC_REQUIRE(e.payload() == 1234);
+    STATIC_REQUIRE(e.raw() == (std::uint64_t(2) << 48 | std::uint64_t(1) << 32 | 1234));
+    STATIC_REQUIRE(e == RootError::D);
+    STATIC_REQUIRE_FALSE(e == TestError::B);
+    STATIC_REQUIRE(e.is<RootError>());
+    STATIC_REQUIRE(e.as<RootError>() == RootError::D);
+    STATIC_REQUIRE(ErrorCode::from_bits(e.raw()) == e);
+    STATIC_REQUIRE(std::is_trivially_copyable_v<Result<int, ErrorCode>>);
+}
+
+TEST_CASE("errors from different enums share one Result type", "ErrorCode") {
+    auto parse = [] (int i) -> Result<int, ErrorCode> {
+        if (i < 0) {
+            return err<int, ErrorCode>(TestError::A);
+        }
+        return ok<int, ErrorCode>(i);
+    };
+    auto lookup = [&] (int i) -> Result<int, ErrorCode> {
+        return parse(i).and_then([] (int v) {
+            return v > 10 ? err<int, ErrorCode>(ErrorCode(RootError::C, static_cast<std::uint32_t>(v))) : ok<int, ErrorCode>(v);
+        });
+    };
+
+    REQUIRE(unwrap(lookup(3)) == 3);
+    REQUIRE(lookup(-1).error == TestError::A);
+    REQUIRE(lookup(42).error == RootError::C);
+    REQUIRE(lookup(42).error.payload() == 42);
+
+    auto converted = into_code(err<int, TestError>(TestError::B), 7);
+    REQUIRE(converted.error == TestError::B);
+    REQUIRE(converted.error.payload() == 7);
+}
+
+enum class WideCodeError {
+    Small = 1,
+    Large = 0x10000,
+    Negative = -1,
+};
+
+template<>
+struct Display<WideCodeError> {
+    static void print(WideCodeError) {}
+};
+
+RESULT_ERROR_CATEGORY(WideCodeError, 3, "wide");
+
+// Has the id of TestError but is left to the test to register
+enum class ClashError {
+    X,
+};
+
+template<>
+struct Display<ClashError> {
+    static void print(ClashError) {}
+};
+
+template<>
+struct ErrorCategory<ClashError> {
+    static constexpr std::uint16_t id = 1;
+    static constexpr const char* name = "clash";
+};
+
+TEST_CASE("ErrorCode rejects duplicate categories and wide codes", "ErrorCode") {
+    STATIC_REQUIRE(ErrorCode(WideCodeError::Small).code() == 1);
+    REQUIRE(detail::register_category<TestError>());
+
+    auto status = child_status([] { (void)detail::register_category<ClashError>(); });
+    REQUIRE(WIFSIGNALED(status));
+    REQUIRE(WTERMSIG(status) == SIGABRT);
+
+    status = child_status([] { (void)ErrorCode(WideCodeError::Large); });
+    REQUIRE(WIFSIGNALED(status));
+    status = child_status([] { (void)ErrorCode(WideCodeError::Negative); });
+    REQUIRE(WIFSIGNALED(status));
+}
+
+enum class MirrorError {
+    A,
+    B,
+};
+
+template<>
+struct From<TestError, MirrorError> : FromTable<error_table<TestError, MirrorError>({
+    { TestError::A, MirrorError::A },
+    { TestError::B, MirrorError::B },
+})> {};
+
+template<>
+struct From<TestError, RootError> : FromTable<error_table<TestError, RootError>({
+    { TestError::B, RootError::C },
+    { TestError::A, RootError::C },
+})> {};
+
+TEST_CASE("error tables convert at compile time", "From") {
+    constexpr auto mirror = error_table<TestError, MirrorError>({
+        { TestError::A, MirrorError::A },
+        { TestError::B, MirrorError::B },
+    });
+    STATIC_REQUIRE(mirror.identity);
+    STATIC_REQUIRE(mirror(TestError::B) == MirrorError::B);
+
+    constexpr auto collapse = error_table<TestError, RootError>({
+        { TestError::A, RootError::D },
+        { TestError::B, RootError::C },
+    });
+    STATIC_REQUIRE_FALSE(collapse.identity);
+    STATIC_REQUIRE(collapse(TestError::A) == RootError::D);
+}
+
+enum class WideError {
+    A,
+    B,
+    C,
+};
+
+TEST_CASE("error tables trap on unlisted source values", "From") {
+    static constexpr auto narrow = error_table<WideError, MirrorError>({
+        { WideError::A, MirrorError::B },
+        { WideError::B, MirrorError::A },
+    });
+    static constexpr auto same = error_table<WideError, MirrorError>({
+        { WideError::A, MirrorError::A },
+        { WideError::B, MirrorError::B },
+    });
+    REQUIRE(narrow(WideError::B) == MirrorError::A);
+
+    auto status = child_status([] { (void)narrow(WideError::C); });
+    REQUIRE(WIFSIGNALED(status));
+    status = child_status([] { (void)same(WideError::C); });
+    REQUIRE(WIFSIGNALED(status));
+}
+
+TEST_CASE("Result converts implicitly through From", "From") {
+    auto lookup = [] (bool fail) -> Result<int, RootError> {
+        return fail ? err<int, TestError>(TestError::A) : ok<int, TestError>(5);
+    };
+    REQUIRE(unwrap(lookup(false)) == 5);
+    REQUIRE(lookup(true).error == RootError::C);
+
+    Result<void, MirrorError> v = err<void, TestError>(TestError::B);
+    REQUIRE(v.tag == Result<void, MirrorError>::Tag::Err);
+    REQUIRE(v.error == MirrorError::B);
+
+    Result<int, ErrorCode> code = err<int, TestError>(TestError::B);
+    REQUIRE(code.error == TestError::B);
+
+    STATIC_REQUIRE_FALSE(std::is_convertible_v<Result<int, RootError>, Result<int, TestError>>);
+}
+
+TEST_CASE("DynError holds and downcasts small errors inline", "DynError") {
+    STATIC_REQUIRE(sizeof(DynError) == 4 * sizeof(void*));
+
+    DynError e = TestError::B;
+    REQUIRE(e.is<TestError>());
+    REQUIRE_FALSE(e.is<RootError>());
+    REQUIRE(*e.downcast<TestError>() == TestError::B);
+    REQUIRE(e.downcast<RootError>() == nullptr);
+
+    auto copy = e;
+    REQUIRE(*copy.downcast<TestError>() == TestError::B);
+
+    auto moved = std::move(copy);
+    REQUIRE(copy.empty());
+    REQUIRE(*moved.downcast<TestError>() == TestError::B);
+}
+
+TEST_CASE("DynError stores oversize errors out of line", "DynError") {
+    DynError e = LargeError { 9, "large" };
+    REQUIRE(e.is<LargeError>());
+    REQUIRE(e.downcast<LargeError>()->code == 9);
+
+    DynError copy = e;
+    REQUIRE(copy.downcast<LargeError>() != e.downcast<LargeError>());
+    REQUIRE(std::string(copy.downcast<LargeError>()->context) == "large");
+
+    copy = DynError(RootError::D);
+    REQUIRE(*copy.downcast<RootError>() == RootError::D);
+}
+
+TEST_CASE("Results of any error convert into Result<T, DynError>", "DynError") {
+    auto plugin = [] (int i) -> Result<int, DynError> {
+        if (i == 0) {
+            return err<int, TestError>(TestError::A);
+        }
+        if (i == 1) {
+            return err<int, LargeError>(LargeError { 1, "" });
+        }
+        return ok<int, RootError>(i);
+    };
+
+    REQUIRE(unwrap(plugin(5)) == 5);
+    REQUIRE(plugin(0).error.is<TestError>());
+    REQUIRE(plugin(1).error.downcast<LargeError>()->code == 1);
+
+    auto r = plugin(0);
+    auto copy = r;
+    REQUIRE(*copy.error.downcast<TestError>() == TestError::A);
+}
+
+TEST_CASE("InlineMessage formats into a fixed buffer", "Message") {
+    STATIC_REQUIRE(std::is_trivially_copyable_v<InlineMessage<>>);
+    STATIC_REQUIRE(std::is_trivially_copyable_v<Result<int, InlineMessage<>>>);
+
+    auto m = InlineMessage<>::format("code %d at %s", 7, "parse");
+    REQUIRE(m.view() == "code 7 at parse");
+    REQUIRE_FALSE(m.truncated());
+
+    // Truncation is the point here, GCC warns about it at -O2
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#endif
+    auto cut = InlineMessage<8>::format("%s", "a message that does not fit");
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+    REQUIRE(cut.view() == "a messa");
+    REQUIRE(cut.truncated());
+
+    InlineMessage<16> plain = "plain";
+    REQUIRE(plain.size() == 5);
+}
+
+TEST_CASE("LazyMessage renders its arguments only when asked", "Message") {
+    STATIC_REQUIRE(std::is_trivially_copyable_v<LazyMessage<>>);
+
+    auto m = lazy_message("port %d out of range %u..%u", 70000, 1u, 65535u);
+    REQUIRE(std::string(m.format_string()) == "port %d out of range %u..%u");
+    REQUIRE(m.render().view() == "port 70000 out of range 1..65535");
+    REQUIRE(m.render<8>().view() == "port 70");
+
+    auto copy = m;
+    REQUIRE(copy.render().view() == m.render().view());
+    REQUIRE(LazyMessage<>().render().size() == 0);
+}
+
+TEST_CASE("message errors work with map_err and unwrap", "Message") {
+    auto r = err<int, TestError>(TestError::B).map_err([] (TestError e) {
+        return lazy_message("lookup failed: %d", static_cast<int>(e));
+    });
+    REQUIRE(r.tag == Result<int, LazyMessage<>>::Tag::Err);
+    REQUIRE(r.error.render().view() == "lookup failed: 1");
+
+    auto eager = r.map_err([] (const LazyMessage<>& m) { return m.render<32>(); });
+    REQUIRE(eager.error.view() == "lookup failed: 1");
+    REQUIRE(unwrap_or(eager, 3) == 3);
+
+    auto status = child_status([r] { (void)unwrap(r); });
+    REQUIRE((WIFEXITED(status) && WEXITSTATUS(status) == 1));
+}
+
+TEST_CASE("SmallVector spills to the heap past N", "Validated") {
+    SmallVector<std::string, 2> v;
+    v.push_back("a");
+    v.push_back("b");
+    REQUIRE_FALSE(v.spilled());
+
+    v.push_back(std::string(64, 'c'));
+    REQUIRE(v.spilled());
+    REQUIRE(v.size() == 3);
+
+    auto copy = v;
+    auto moved = std::move(v);
+    REQUIRE(moved.spilled());
+    REQUIRE(v.empty());
+    REQUIRE(copy[2] == moved[2]);
+
+    SmallVector<std::string, 2> small;
+    small.push_back("x");
+    moved = std::move(small);
+    REQUIRE_FALSE(moved.spilled());
+    REQUIRE(moved[0] == "x");
+}
+
+static auto validate_positive(int x) -> Result<void, TestError> {
+    if (x <= 0) {
+        return err<void, TestError>(TestError::A);
+    }
+    return ok<TestError>();
+}
+
+static auto validate_even(int x) -> Validated<void, TestError> {
+    if (x % 2 != 0) {
+        return invalid<void, TestError>(TestError::B);
+    }
+    return valid<TestError>();
+}
+
+TEST_CASE("check runs every validation and collects all errors", "Validated") {
+    auto good = check(4, validate_positive, validate_even);
+    REQUIRE(good.is_valid());
+    REQUIRE(good.value() == 4);
+
+    auto bad = check(-3, validate_positive, validate_even);
+    REQUIRE_FALSE(bad.is_valid());
+    REQUIRE(bad.errors().size() == 2);
+    REQUIRE(bad.errors()[0] == TestError::A);
+    REQUIRE(bad.errors()[1] == TestError::B);
+
+    auto odd = check(3, validate_positive, validate_even);
+    REQUIRE(odd.errors().size() == 1);
+    REQUIRE(odd.errors()[0] == TestError::B);
+}
+
+TEST_CASE("combine applies a function to independent valid inputs", "Validated") {
+    auto make = [] (int a, const std::string& b) { return b + std::to_string(a); };
+
+    auto both = combine(make, valid<int, TestError>(1), valid<std::string, TestError>("x"));
+    REQUIRE(both.value() == "x1");
+
+    auto errors = combine(make, check(-1, validate_positive, validate_even), invalid<std::string, TestError>(TestError::A));
+    REQUIRE(errors.errors().size() == 3);
+    REQUIRE(errors.errors()[2] == TestError::A);
+
+    auto mapped = both.map([] (const std::string& s) { return s.size(); });
+    REQUIRE(mapped.value() == 2);
+}
+
+TEST_CASE("Validated converts to and from Result", "Validated") {
+    Validated<int, TestError> from_ok = ok<int, TestError>(5);
+    REQUIRE(from_ok.value() == 5);
+
+    Validated<int, TestError> from_err = err<int, TestError>(TestError::B);
+    REQUIRE(from_err.errors().size() == 1);
+
+    Validated<int, TestError, 2> many = invalid<int, TestError, 2>(TestError::A);
+    for (int i = 0; i < 4; ++i) {
+        many.add_error(TestError::B);
+    }
+    REQUIRE(many.errors().spilled());
+
+    auto first = many.to_result();
+    REQUIRE(first.tag == Result<int, TestError>::Tag::Err);
+    REQUIRE(first.error == TestError::A);
+
+    auto all = std::move(many).into_result();
+    REQUIRE(all.tag == Result<int, SmallVector<TestError, 2>>::Tag::Err);
+    REQUIRE(all.error.size() == 5);
+    REQUIRE(unwrap_or(all, 7) == 7);
+
+    REQUIRE(from_ok.to_result().value == 5);
+    REQUIRE(check(2, validate_even).to_result().tag == Result<int, TestError>::Tag::Ok);
+}
+
+TEST_CASE("parse reads integers in one pass", "parse") {
+    REQUIRE(parse<std::int64_t>("-9223372036854775808").value == INT64_MIN);
+    REQUIRE(parse<std::uint32_t>("4294967295").value == 4294967295u);
+    REQUIRE(parse<int>("0042").value == 42);
+    REQUIRE(parse<std::uint32_t>("ff", 16).value == 255u);
+
+    REQUIRE(parse<int>("").error == ParseError::Empty);
+    REQUIRE(parse<int>("12a").error == ParseError::NotANumber);
+    REQUIRE(parse<int>(" 12").error == ParseError::NotANumber);
+    REQUIRE(parse<int>("+12").error == ParseError::NotANumber);
+    REQUIRE(parse<std::uint32_t>("-1").error == ParseError::NotANumber);
+    REQUIRE(parse<std::uint32_t>("4294967296").error == ParseError::Overflow);
+    REQUIRE(parse<std::int64_t>("99999999999999999999").error == ParseError::Overflow);
+}
+
+TEST_CASE("parse reads floating point without locale", "parse") {
+    REQUIRE(parse<double>("0.75").value == 0.75);
+    REQUIRE(parse<double>("-1e3").value == -1000.0);
+    REQUIRE(parse<float>("2.5").value == 2.5f);
+
+    REQUIRE(parse<double>("1,5").error == ParseError::NotANumber);
+    REQUIRE(parse<double>("1e999").error == ParseError::Overflow);
+    REQUIRE(parse<double>(".").error == ParseError::NotANumber);
+
+    std::string_view line = "12,34";
+    REQUIRE(parse<int>(line.substr(0, 2)).value == 12);
+    REQUIRE(parse<int>(line.substr(3)).value == 34);
+}
+
+TEST_CASE("ResultVector stores Ok bits next to dense values", "ResultVector") {
+    ResultVector<std::int64_t, ParseError> v;
+    for (int i = 0; i < 130; ++i) {
+        if (i % 3 == 0) {
+            v.push_err(ParseError::Empty);
+        } else {
+            v.push_ok(i);
+        }
+    }
+    REQUIRE(v.size() == 130);
+    REQUIRE(v.bitmap_words() == 3);
+    REQUIRE(v.ok_count() == 86);
+    REQUIRE(v.is_ok(128));
+    REQUIRE(v.value(128) == 128);
+    REQUIRE(v[129].error == ParseError::Empty);
+    REQUIRE(v[1].value == 1);
+
+    auto copy = v;
+    v.clear();
+    REQUIRE(v.ok_count() == 0);
+    REQUIRE(copy.ok_count() == 86);
+}
+
+TEST_CASE("parse_fields reports every field of a delimited buffer", "parse") {
+    auto v = parse_fields("12,-7,,abc,99999999999999999999,1234567890123456,-", ',');
+    REQUIRE(v.size() == 7);
+    REQUIRE(v[0].value == 12);
+    REQUIRE(v[1].value == -7);
+    REQUIRE(v[2].error == ParseError::Empty);
+    REQUIRE(v[3].error == ParseError::NotANumber);
+    REQUIRE(v[4].error == ParseError::Overflow);
+    REQUIRE(v[5].value == 1234567890123456);
+    REQUIRE(v[6].error == ParseError::NotANumber);
+
+    REQUIRE(parse_fields("1\n2\n", '\n').size() == 2);
+    REQUIRE(parse_fields("", ',').size() == 0);
+}
+
+TEST_CASE("parse_fields agrees with the scalar parser", "parse") {
+    std::mt19937 rng(11);
+    const char alphabet[] = "0123456789000000000-+x ,";
+    std::string buf;
+    for (int i = 0; i < 4096; ++i) {
+        buf += alphabet[rng() % (sizeof(alphabet) - 1)];
+    }
+
+    auto fast = parse_fields(buf, ',');
+    ResultVector<std::int64_t, ParseError> slow;
+    detail::parse_fields_scalar(buf, ',', slow);
+    REQUIRE(fast.size() == slow.size());
+    for (std::size_t i = 0; i < fast.size(); ++i) {
+        REQUIRE(fast.is_ok(i) == slow.is_ok(i));
+        if (fast.is_ok(i)) {
+            REQUIRE(fast.value(i) == slow.value(i));
+        } else {
+            REQUIRE(fast.error(i) == slow.error(i));
+        }
+    }
+}
+
+// Pipe whose read end yields `data`, for RecordReader tests
+static auto pipe_with(std::string_view data) -> int {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    REQUIRE(write(fds[1], data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    close(fds[1]);
+    return fds[0];
+}
+
+TEST_CASE("RecordReader splits records across buffer refills", "RecordReader") {
+    auto fd = pipe_with("12\n345\n\n6789\nlast");
+    RecordReader reader(fd, '\n', 8);
+    std::vector<std::string> records;
+    while (auto r = reader.next()) {
+        records.emplace_back(*r);
+    }
+    close(fd);
+
+    REQUIRE(records == std::vector<std::string> { "12", "345", "", "6789", "last" });
+    REQUIRE(reader.status().tag == Result<void, ReadError>::Tag::Ok);
+}
+
+TEST_CASE("RecordReader yields a Result per parsed record", "RecordReader") {
+    auto fd = pipe_with("1,2,x,4,99999999999999999999,");
+    RecordReader reader(fd, ',', 24);
+    std::vector<Result<std::int64_t, ParseError>> parsed;
+    for (auto r : reader.records([] (std::string_view s) { return parse<std::int64_t>(s); })) {
+        parsed.push_back(r);
+    }
+    close(fd);
+
+    REQUIRE(parsed.size() == 5);
+    REQUIRE(parsed[1].value == 2);
+    REQUIRE(parsed[2].error == ParseError::NotANumber);
+    REQUIRE(parsed[4].error == ParseError::Overflow);
+}
+
+TEST_CASE("RecordReader reports oversized records and read failures", "RecordReader") {
+    auto fd = pipe_with("ok\nthis record is too long\nnever");
+    RecordReader reader(fd, '\n', 8);
+    std::int64_t sum = 0;
+    auto n = for_each_record(reader, [] (std::string_view s) { return ok<std::size_t, ParseError>(s.size()); }, [&] (auto r) {
+        sum += static_cast<std::int64_t>(r.value);
+    });
+    close(fd);
+    REQUIRE(n.tag == Result<std::size_t, ReadError>::Tag::Err);
+    REQUIRE(n.error == ReadError::RecordTooLong);
+    REQUIRE(sum == 2);
+
+    RecordReader closed(-1);
+    REQUIRE_FALSE(closed.next().has_value());
+    REQUIRE(closed.status().error == ReadError::Io);
+    REQUIRE(closed.error_number() == EBADF);
+}
+
+// Temporary file holding `data`, removed with the object
+struct TempFile {
+    char path[32] = "/tmp/result_tests_XXXXXX";
+
+    explicit TempFile(std::string_view data) {
+        int fd = mkstemp(path);
+        REQUIRE(fd >= 0);
+        REQUIRE(write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+        close(fd);
+    }
+
+    ~TempFile() {
+        unlink(path);
+    }
+};
+
+TEST_CASE("MappedFile maps a file for the parsers without copying", "MappedFile") {
+    TempFile tmp("10,20,x,40");
+    auto file = MappedFile::open(tmp.path);
+    REQUIRE(file.tag == Result<MappedFile, IoError>::Tag::Ok);
+    REQUIRE(file.value.size() == 10);
+    REQUIRE(file.value.bytes()[0] == std::byte { '1' });
+    REQUIRE(file.value.advise(Advice::Sequential).tag == Result<void, IoError>::Tag::Ok);
+
+    auto moved = unwrap(std::move(file));
+    auto fields = parse_fields(moved.text(), ',');
+    REQUIRE(fields.size() == 4);
+    REQUIRE(fields[3].value == 40);
+    REQUIRE(fields[2].error == ParseError::NotANumber);
+
+    TempFile empty("");
+    auto none = unwrap(MappedFile::open(empty.path));
+    REQUIRE(none.text().empty());
+}
+
+TEST_CASE("MappedFile reports the failing call and its errno", "MappedFile") {
+    auto missing = MappedFile::open("/nonexistent/result_tests");
+    REQUIRE(missing.tag == Result<MappedFile, IoError>::Tag::Err);
+    REQUIRE(missing.error == IoError { IoOp::Open, ENOENT });
+
+    auto dir = MappedFile::open("/");
+    REQUIRE(dir.tag == Result<MappedFile, IoError>::Tag::Err);
+    REQUIRE(dir.error.op == IoOp::Map);
+}
+
+TEST_CASE("IoRing completes batched reads and writes as Results", "IoRing") {
+    for (auto backend : { IoBackend::IoUring, IoBackend::Sync }) {
+        TempFile tmp("0123456789abcdef");
+        int fd = open(tmp.path, O_RDWR);
+        REQUIRE(fd >= 0);
+        IoRing ring(4, backend);
+
+        char bufs[6][4] = {};
+        std::vector<IoHandle> handles;
+        for (int i = 0; i < 6; ++i) {
+            // Six requests through a four-entry queue submit the first batch early
+            handles.push_back(unwrap(ring.read(fd, bufs[i], 4, static_cast<std::uint64_t>(i) * 2)));
+        }
+        REQUIRE(ring.in_flight() == 6);
+        unwrap(ring.submit());
+
+        std::vector<std::pair<IoHandle, std::size_t>> done;
+        while (ring.in_flight() != 0) {
+            unwrap(ring.wait(1, [&](IoHandle h, Result<std::size_t, IoError> r) {
+                done.emplace_back(h, unwrap(std::move(r)));
+            }));
+        }
+        REQUIRE(done.size() == 6);
+        for (auto [h, n] : done) {
+            REQUIRE(std::find(handles.begin(), handles.end(), h) != handles.end());
+            REQUIRE(n == 4);
+        }
+        REQUIRE(std::string_view(bufs[5], 4) == "abcd");
+
+        auto w = unwrap(ring.write(fd, "XY", 2, 14));
+        std::size_t written = 0;
+        unwrap(ring.wait(1, [&](IoHandle h, Result<std::size_t, IoError> r) {
+            REQUIRE(h == w);
+            written = unwrap(std::move(r));
+        }));
+        REQUIRE(written == 2);
+        char tail[2];
+        REQUIRE(pread(fd, tail, 2, 14) == 2);
+        REQUIRE(std::string_view(tail, 2) == "XY");
+        close(fd);
+    }
+}
+
+TEST_CASE("IoRing reports failed requests with the operation and errno", "IoRing") {
+    for (auto backend : { IoBackend::IoUring, IoBackend::Sync }) {
+        IoRing ring(8, backend);
+        char buf[4];
+        unwrap(ring.read(-1, buf, sizeof buf, 0));
+        unwrap(ring.write(-1, buf, sizeof buf, 0));
+        std::vector<IoError> errors;
+        unwrap(ring.wait(2, [&](IoHandle, Result<std::size_t, IoError> r) {
+            REQUIRE(r.tag == Result<std::size_t, IoError>::Tag::Err);
+            errors.push_back(r.error);
+        }));
+        REQUIRE(errors.size() == 2);
+        REQUIRE(std::find(errors.begin(), errors.end(), IoError { IoOp::Read, EBADF }) != errors.end());
+        REQUIRE(std::find(errors.begin(), errors.end(), IoError { IoOp::Write, EBADF }) != errors.end());
+        REQUIRE(ring.poll([](IoHandle, Result<std::size_t, IoError>) {}) == 0);
+    }
+}
+
+TEST_CASE("IoRing keeps in-flight requests within the completion ring", "IoRing") {
+    IoRing ring(2);
+    if (ring.backend() != IoBackend::IoUring) {
+        return; // the sync backend has no completion ring
+    }
+    TempFile tmp("0123456789abcdef");
+    int fd = open(tmp.path, O_RDONLY);
+    REQUIRE(fd >= 0);
+
+    char bufs[4][4];
+    for (auto& buf : bufs) {
+        unwrap(ring.read(fd, buf, sizeof buf, 0));
+    }
+    // Two queue entries, four completion slots
+    auto full = ring.read(fd, bufs[0], sizeof bufs[0], 0);
+    REQUIRE(full.tag == Result<IoHandle, IoError>::Tag::Err);
+    REQUIRE(full.error == IoError { IoOp::Submit, EBUSY });
+
+    unsigned reaped = 0;
+    while (ring.in_flight() != 0) {
+        reaped += unwrap(ring.wait(1, [](IoHandle, Result<std::size_t, IoError> r) { REQUIRE(unwrap(std::move(r)) == 4); }));
+    }
+    REQUIRE(reaped == 4);
+    unwrap(ring.read(fd, bufs[0], sizeof bufs[0], 0));
+    close(fd);
+}
+
+TEST_CASE("sys::check maps each failure convention to Errno", "sys") {
+    auto minus_one = sys::check<sys::MinusOne>([](int x) { errno = EAGAIN; return x; }, -1);
+    STATIC_REQUIRE(std::is_same_v<decltype(minus_one), Result<int, sys::Errno>>);
+    REQUIRE(minus_one.tag == Result<int, sys::Errno>::Tag::Err);
+    REQUIRE(minus_one.error == sys::Errno { EAGAIN });
+    REQUIRE(sys::check<sys::MinusOne>([] { return 3L; }).value == 3L);
+
+    auto negative = sys::check<sys::Negative>([] { return -EINVAL; });
+    REQUIRE(negative.error == sys::Errno { EINVAL });
+    REQUIRE(sys::check<sys::Negative>([] { return 0; }).tag == Result<int, sys::Errno>::Tag::Ok);
+
+    auto non_zero = sys::check<sys::NonZero>([] { return EBUSY; });
+    STATIC_REQUIRE(std::is_same_v<decltype(non_zero), Result<void, sys::Errno>>);
+    REQUIRE(non_zero.error == sys::Errno { EBUSY });
+
+    auto unit = sys::check<sys::MinusOne, void>([] { return 0; });
+    STATIC_REQUIRE(std::is_same_v<decltype(unit), Result<void, sys::Errno>>);
+    REQUIRE(unit.tag == Result<void, sys::Errno>::Tag::Ok);
+}
+
+TEST_CASE("sys wrappers return the call's errno", "sys") {
+    REQUIRE(sys::close(-1).error == sys::Errno { EBADF });
+    REQUIRE(sys::open("/nonexistent/result_tests", O_RDONLY).error == sys::Errno { ENOENT });
+
+    auto file = sys::fopen("/nonexistent/result_tests", "r");
+    REQUIRE(file.tag == Result<std::FILE*, sys::Errno>::Tag::Err);
+    REQUIRE(file.error == sys::Errno { ENOENT });
+
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    REQUIRE(unwrap(sys::write(fds[1], "abc", 3)) == 3);
+    char buf[4] = {};
+    REQUIRE(unwrap(sys::read(fds[0], buf, sizeof buf)) == 3);
+    REQUIRE(std::string_view(buf) == "abc");
+    REQUIRE(sys::lseek(fds[0], 0, SEEK_SET).error == sys::Errno { ESPIPE });
+    REQUIRE(sys::close(fds[0]).tag == Result<void, sys::Errno>::Tag::Ok);
+    REQUIRE(sys::close(fds[1]).tag == Result<void, sys::Errno>::Tag::Ok);
+}
+
+TEST_CASE("SpscQueue delivers items in order, then the terminal error", "ResultQueue") {
+    SpscQueue<int, TestError> q(3);
+    REQUIRE(q.capacity() == 4);
+    REQUIRE(q.try_pop() == std::nullopt);
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(q.try_push(i == 2 ? err<int, TestError>(TestError::A) : ok<int, TestError>(i)));
+    }
+    REQUIRE_FALSE(q.try_push(ok<int, TestError>(4)));
+
+    REQUIRE(q.pop().value.value == 0);
+    REQUIRE(q.close(TestError::B));
+    REQUIRE_FALSE(q.close(TestError::A));
+    REQUIRE_FALSE(q.push(ok<int, TestError>(5)));
+
+    REQUIRE(q.pop().value.value == 1);
+    auto item_error = q.pop();
+    REQUIRE(item_error.tag == Result<Result<int, TestError>, TestError>::Tag::Ok);
+    REQUIRE(item_error.value.error == TestError::A);
+    REQUIRE(q.pop().value.value == 3);
+    auto terminal = q.pop();
+    REQUIRE(terminal.tag == Result<Result<int, TestError>, TestError>::Tag::Err);
+    REQUIRE(terminal.error == TestError::B);
+    REQUIRE(q.pop().error == TestError::B);
+}
+
+TEST_CASE("SpscQueue and MpmcQueue pass every item between threads", "ResultQueue") {
+    constexpr int per_producer = 20000;
+
+    SpscQueue<std::string, TestError> spsc(16);
+    std::thread producer([&] {
+        for (int i = 0; i < per_producer; ++i) {
+            spsc.push(ok<std::string, TestError>(std::to_string(i)));
+        }
+        spsc.close(TestError::B);
+    });
+    int in_order = 0;
+    for (auto next = spsc.pop(); next.tag == decltype(next)::Tag::Ok; next = spsc.pop()) {
+        in_order += next.value.value == std::to_string(in_order);
+    }
+    producer.join();
+    REQUIRE(in_order == per_producer);
+
+    MpmcQueue<std::int64_t, TestError> mpmc(64);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < per_producer; ++i) {
+                // Every tenth item is an error, the rest carry their index
+                mpmc.push(i % 10 == 0 ? err<std::int64_t, TestError>(TestError::A) : ok<std::int64_t, TestError>(p * per_producer + i));
+            }
+        });
+    }
+    std::atomic<std::int64_t> sum { 0 };
+    std::atomic<int> errors { 0 };
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < 2; ++c) {
+        consumers.emplace_back([&] {
+            for (auto next = mpmc.pop(); next.tag == decltype(next)::Tag::Ok; next = mpmc.pop()) {
+                if (next.value.tag == Result<std::int64_t, TestError>::Tag::Ok) {
+                    sum += next.value.value;
+                } else {
+                    ++errors;
+                }
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    mpmc.close(TestError::B);
+    for (auto& t : consumers) {
+        t.join();
+    }
+
+    std::int64_t want = 0;
+    for (int p = 0; p < 4; ++p) {
+        for (int i = 0; i < per_producer; ++i) {
+            want += i % 10 == 0 ? 0 : p * per_producer + i;
+        }
+    }
+    REQUIRE(errors == 4 * per_producer / 10);
+    REQUIRE(sum == want);
+    REQUIRE(mpmc.try_pop() == std::nullopt);
+}
+
+TEST_CASE("ErrorSink queues compact records for the drain", "ErrorSink") {
+    ErrorSink sink({ .interval = std::chrono::milliseconds(0) });
+    sink.report(TestError::A);
+    sink.report(TestError::B);
+    sink.report(RootError::C);
+
+    std::vector<ErrorRecord> records;
+    REQUIRE(sink.drain([&](const ErrorRecord& r) { records.push_back(r); }) == 3);
+    REQUIRE(records[0].is<TestError>());
+    REQUIRE(records[0].as<TestError>() == TestError::A);
+    REQUIRE(records[1].as<TestError>() == TestError::B);
+    REQUIRE(records[2].is<RootError>());
+    REQUIRE_FALSE(records[2].is<TestError>());
+    REQUIRE(sink.drain([](const ErrorRecord&) {}) == 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 500; ++i) {
+                sink.report(TestError::A);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    REQUIRE(sink.drain([](const ErrorRecord&) {}) == 2000);
+    REQUIRE(sink.dropped() == 0);
+}
+
+TEST_CASE("ErrorSink keeps the rings of several sinks per thread", "ErrorSink") {
+    // One more sink than the per-thread cache holds
+    std::vector<std::unique_ptr<ErrorSink>> sinks;
+    for (int i = 0; i < 5; ++i) {
+        sinks.push_back(std::make_unique<ErrorSink>(ErrorSink::Options { .interval = std::chrono::milliseconds(0) }));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        sinks[static_cast<std::size_t>(i % 5)]->report(TestError::A);
+        sinks[static_cast<std::size_t>(i % 2)]->report(TestError::B);
+    }
+    REQUIRE(sinks[0]->drain([](const ErrorRecord&) {}) == 700);
+    REQUIRE(sinks[1]->drain([](const ErrorRecord&) {}) == 700);
+    for (std::size_t i = 2; i < 5; ++i) {
+        REQUIRE(sinks[i]->drain([](const ErrorRecord&) {}) == 200);
+    }
+}
+
+enum class HugeError : std::int64_t {
+    Min = INT64_MIN,
+    Max = INT64_MAX,
+};
+
+template<>
+struct Display<HugeError> {
+    static void print(HugeError) {}
+};
+
+TEST_CASE("ErrorSink in Dedup mode takes any enum value", "ErrorSink") {
+    ErrorSink sink({ .mode = SinkMode::Dedup, .window = std::chrono::seconds(60), .interval = std::chrono::milliseconds(0) });
+    for (int i = 0; i < 10; ++i) {
+        sink.report(HugeError::Min);
+        sink.report(HugeError::Max);
+    }
+    std::vector<ErrorRecord> records;
+    REQUIRE(sink.drain([&](const ErrorRecord& r) { records.push_back(r); }) == 2);
+    REQUIRE(records[0].as<HugeError>() == HugeError::Min);
+    REQUIRE(records[1].as<HugeError>() == HugeError::Max);
+}
+
+TEST_CASE("ErrorSink drops records when a ring is full", "ErrorSink") {
+    ErrorSink sink({ .interval = std::chrono::milliseconds(0), .ring_size = 4 });
+    for (int i = 0; i < 10; ++i) {
+        sink.report(TestError::A);
+    }
+    REQUIRE(sink.drain([](const ErrorRecord&) {}) == 4);
+    REQUIRE(sink.dropped() == 6);
+}
+
+TEST_CASE("ErrorSink in Dedup mode records each error once per window", "ErrorSink") {
+    ErrorSink sink({ .mode = SinkMode::Dedup, .window = std::chrono::milliseconds(50), .interval = std::chrono::milliseconds(0) });
+    for (int i = 0; i < 1000; ++i) {
+        sink.report(TestError::A);
+    }
+    sink.report(TestError::B);
+
+    std::vector<ErrorRecord> records;
+    auto collect = [&](const ErrorRecord& r) { records.push_back(r); };
+    REQUIRE(sink.drain(collect) == 2);
+    REQUIRE(records[0].as<TestError>() == TestError::A);
+    REQUIRE(records[0].kind == RecordKind::Error);
+    REQUIRE(records[1].as<TestError>() == TestError::B);
+
+    // The window is still open: the count is held back
+    records.clear();
+    REQUIRE(sink.drain(collect) == 0);
+
+    // Once it has ended the drain publishes the count without a new report
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    REQUIRE(sink.drain(collect) == 1);
+    REQUIRE(records[0].kind == RecordKind::Suppressed);
+    REQUIRE(records[0].as<TestError>() == TestError::A);
+    REQUIRE(records[0].repeats == 999);
+
+    // A report after the window is a fresh occurrence
+    sink.report(TestError::A);
+    records.clear();
+    REQUIRE(sink.drain(collect) == 1);
+    REQUIRE(records[0].kind == RecordKind::Error);
+}
+
+TEST_CASE("ErrorSink in Dedup mode counts every report once under a concurrent drain", "ErrorSink") {
+    ErrorSink sink({ .mode = SinkMode::Dedup, .window = std::chrono::milliseconds(1), .interval = std::chrono::milliseconds(0) });
+    constexpr int per_thread = 200000;
+    std::uint64_t counted = 0;
+    auto count = [&](const ErrorRecord& r) { counted += r.kind == RecordKind::Suppressed ? r.repeats : 1; };
+
+    std::atomic<int> running { 4 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < per_thread; ++i) {
+                sink.report(i % 3 == t % 3 ? TestError::A : TestError::B);
+            }
+            running.fetch_sub(1);
+        });
+    }
+    while (running.load() != 0) {
+        sink.drain(count);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    sink.drain(count);
+    REQUIRE(sink.dropped() == 0);
+    REQUIRE(counted == 4 * per_thread);
+}
+
+TEST_CASE("ErrorSink prints the count of a trailing storm on destruction", "ErrorSink") {
+    auto out = std::tmpfile();
+    REQUIRE(out != nullptr);
+    auto status = child_status([&] {
+        dup2(fileno(out), STDERR_FILENO);
+        ErrorSink sink({ .mode = SinkMode::Dedup, .window = std::chrono::seconds(60) });
+        for (int i = 0; i < 1000; ++i) {
+            sink.report(TestError::A);
+        }
+    });
+    REQUIRE(WIFEXITED(status));
+
+    char text[256] = {};
+    std::rewind(out);
+    auto size = std::fread(text, 1, sizeof(text) - 1, out);
+    std::fclose(out);
+    REQUIRE(size > 0);
+    REQUIRE(std::strstr(text, "(999 more suppressed)") != nullptr);
+}
+
+TEST_CASE("memoize caches Ok and Err outcomes for their own TTLs", "memoize") {
+    int calls = 0;
+    auto half = [&](const int& x) {
+        ++calls;
+        return x % 2 == 0 ? ok<int, TestError>(x / 2) : err<int, TestError>(TestError::A);
+    };
+    auto cached = memoize<int>(half, { .ok_ttl = std::chrono::milliseconds(60000), .err_ttl = std::chrono::milliseconds(20) });
+    STATIC_REQUIRE(std::is_same_v<decltype(cached(0)), Result<int, TestError>>);
+
+    REQUIRE(cached(4).value == 2);
+    REQUIRE(cached(4).value == 2);
+    REQUIRE(cached(3).error == TestError::A);
+    REQUIRE(cached(3).error == TestError::A);
+    REQUIRE(calls == 2);
+    REQUIRE(cached.size() == 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    REQUIRE(cached(3).error == TestError::A);
+    REQUIRE(cached(4).value == 2);
+    REQUIRE(calls == 3);
+
+    cached.invalidate(4);
+    REQUIRE(cached(4).value == 2);
+    REQUIRE(calls == 4);
+
+    auto uncached_errors = memoize<int>(half, { .err_ttl = std::chrono::milliseconds(0) });
+    uncached_errors(1);
+    uncached_errors(1);
+    REQUIRE(calls == 6);
+}
+
+TEST_CASE("memoize shares large values and evicts with CLOCK", "memoize") {
+    int calls = 0;
+    auto name = [&](const int& x) {
+        ++calls;
+        return ok<std::string, TestError>("entry number " + std::to_string(x));
+    };
+    auto cached = memoize<int>(name, { .capacity = 4, .shards = 1 });
+    STATIC_REQUIRE(std::is_same_v<decltype(cached(0)), Result<std::shared_ptr<const std::string>, TestError>>);
+
+    auto first = cached(0);
+    REQUIRE(*first.value == "entry number 0");
+    REQUIRE(cached(0).value == first.value); // the same cached string
+
+    for (int key = 1; key < 4; ++key) {
+        cached(key);
+    }
+    cached(1); // 0 and 1 are referenced, 2 and 3 are not
+    REQUIRE(calls == 4);
+
+    cached(4); // evicts 2
+    REQUIRE(cached.size() == 4);
+    cached(0);
+    cached(1);
+    REQUIRE(calls == 5);
+    cached(2);
+    REQUIRE(calls == 6);
+    REQUIRE(*first.value == "entry number 0"); // still valid
+}
+
+TEST_CASE("memoize shares errors that are not trivially copyable", "memoize") {
+    int calls = 0;
+    auto parse = [&](const int& x) {
+        ++calls;
+        return err<int, std::string>("bad input " + std::to_string(x));
+    };
+    auto cached = memoize<int>(parse, { .err_ttl = std::chrono::milliseconds(60000) });
+    STATIC_REQUIRE(std::is_same_v<decltype(cached(0)), Result<int, std::shared_ptr<const std::string>>>);
+
+    auto first = cached(7);
+    REQUIRE(*first.error == "bad input 7");
+    REQUIRE(cached(7).error == first.error); // the same cached string
+    REQUIRE(calls == 1);
+}
+
+TEST_CASE("memoize serves concurrent callers", "memoize") {
+    std::atomic<int> calls { 0 };
+    auto square = [&](const int& x) {
+        ++calls;
+        return ok<std::int64_t, TestError>(std::int64_t(x) * x);
+    };
+    auto cached = memoize<int>(square, { .capacity = 256 });
+    std::atomic<int> wrong { 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 5000; ++i) {
+                auto key = i % 100;
+                wrong += cached(key).value != std::int64_t(key) * key;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    REQUIRE(wrong == 0);
+    REQUIRE(calls <= 400);
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "result.hpp"
+
+// Columnar sequence of Result<T, E>: one bit per element says Ok or Err and
+// a dense array holds the value or the error. Batch producers append
+// without building a Result per element, and consumers that only want the
+// Ok values can walk the bitmap a word at a time.
+template<typename T, typename E>
+class ResultVector {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<E>, "ResultVector<T, E>: T and E must be trivially copyable");
+
+    union Slot {
+        T value;
+        E error;
+    };
+
+public:
+    // Appends without capacity checks into room reserved by writer(n). The
+    // cursor lives in registers, where push_ok would have to reload the
+    // vector's members after every store through a T*.
+    class Writer {
+    public:
+        auto push_ok(T value) -> void {
+            ::new (&slots[i].value) T(value);
+            ok_bits[i / 64] |= std::uint64_t(1) << (i % 64);
+            ++i;
+        }
+
+        auto push_err(E error) -> void {
+            ::new (&slots[i].error) E(error);
+            ++i;
+        }
+
+    private:
+        friend class ResultVector;
+
+        Writer(Slot* slots, std::uint64_t* ok_bits, std::size_t i) : slots(slots), ok_bits(ok_bits), i(i) {}
+
+        Slot* slots;
+        std::uint64_t* ok_bits;
+        std::size_t i;
+    };
+
+    ResultVector() = default;
+
+    ResultVector(const ResultVector& other) {
+        reserve(other.len);
+        copy_from(other);
+    }
+
+    ResultVector(ResultVector&& other) noexcept
+        : slots(std::exchange(other.slots, nullptr)),
+          ok_bits(std::exchange(other.ok_bits, nullptr)),
+          len(std::exchange(other.len, 0)),
+          cap(std::exchange(other.cap, 0)) {}
+
+    auto operator=(ResultVector other) noexcept -> ResultVector& {
+        std::swap(slots, other.slots);
+        std::swap(ok_bits, other.ok_bits);
+        std::swap(len, other.len);
+        std::swap(cap, other.cap);
+        return *this;
+    }
+
+    ~ResultVector() {
+        std::free(slots);
+        std::free(ok_bits);
+    }
+
+    auto push_ok(T value) -> void {
+        if (len == cap) [[unlikely]] {
+            grow(cap * 2);
+        }
+        ::new (&slots[len].value) T(value);
+        ok_bits[len / 64] |= std::uint64_t(1) << (len % 64);
+        ++len;
+    }
+
+    auto push_err(E error) -> void {
+        if (len == cap) [[unlikely]] {
+            grow(cap * 2);
+        }
+        ::new (&slots[len].error) E(error);
+        ++len;
+    }
+
+    // Room for up to n more elements; finish with commit()
+    auto writer(std::size_t n) -> Writer {
+        reserve(len + n);
+        return Writer(slots, ok_bits, len);
+    }
+
+    auto commit(const Writer& w) -> void {
+        len = w.i;
+    }
+
+    auto reserve(std::size_t n) -> void {
+        if (n > cap) {
+            grow(n);
+        }
+    }
+
+    auto clear() -> void {
+        if (ok_bits != nullptr) {
+            std::memset(ok_bits, 0, words(len) * sizeof(std::uint64_t));
+        }
+        len = 0;
+    }
+
+    auto size() const -> std::size_t {
+        return len;
+    }
+
+    auto is_ok(std::size_t i) const -> bool {
+        return (ok_bits[i / 64] >> (i % 64)) & 1;
+    }
+
+    auto value(std::size_t i) const -> T {
+        return slots[i].value;
+    }
+
+    auto error(std::size_t i) const -> E {
+        return slots[i].error;
+    }
+
+    auto operator[](std::size_t i) const -> Result<T, E> {
+        if (is_ok(i)) {
+            return ok<T, E>(slots[i].value);
+        }
+        return err<T, E>(slots[i].error);
+    }
+
+    auto ok_count() const -> std::size_t {
+        std::size_t n = 0;
+        for (std::size_t w = 0; w < words(len); ++w) {
+            n += static_cast<std::size_t>(std::popcount(ok_bits[w]));
+        }
+        return n;
+    }
+
+    // Bit i % 64 of word i / 64 is set when element i is Ok; bits past
+    // size() are zero.
+    auto bitmap() const -> const std::uint64_t* {
+        return ok_bits;
+    }
+
+    auto bitmap_words() const -> std::size_t {
+        return words(len);
+    }
+
+private:
+    static auto words(std::size_t n) -> std::size_t {
+        return (n + 63) / 64;
+    }
+
+    [[gnu::noinline]] auto grow(std::size_t n) -> void {
+        n = n < 64 ? 64 : (n + 63) & ~std::size_t(63);
+        auto new_slots = static_cast<Slot*>(std::realloc(static_cast<void*>(slots), n * sizeof(Slot)));
+        if (new_slots == nullptr) {
+            throw std::bad_alloc();
+        }
+        slots = new_slots;
+        auto new_bits = static_cast<std::uint64_t*>(std::realloc(ok_bits, words(n) * sizeof(std::uint64_t)));
+        if (new_bits == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::memset(new_bits + words(cap), 0, (words(n) - words(cap)) * sizeof(std::uint64_t));
+        ok_bits = new_bits;
+        cap = n;
+    }
+
+    auto copy_from(const ResultVector& other) -> void {
+        if (other.len != 0) {
+            std::memcpy(static_cast<void*>(slots), other.slots, other.len * sizeof(Slot));
+            std::memcpy(ok_bits, other.ok_bits, words(other.len) * sizeof(std::uint64_t));
+        }
+        len = other.len;
+    }
+
+    Slot* slots = nullptr;
+    std::uint64_t* ok_bits = nullptr;
+    std::size_t len = 0;
+    std::size_t cap = 0;
+};
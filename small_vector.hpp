@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Vector with room for N elements inline. It only allocates once it grows
+// past N, so the common case of a handful of elements stays on the stack.
+template<typename T, std::size_t N>
+class SmallVector {
+    static_assert(N > 0, "SmallVector<T, N>: N must be positive");
+
+public:
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other) {
+        reserve(other.len);
+        for (const auto& x : other) {
+            ::new (ptr + len) T(x);
+            ++len;
+        }
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        take(std::move(other));
+    }
+
+    auto operator=(const SmallVector& other) -> SmallVector& {
+        if (this != &other) {
+            clear();
+            reserve(other.len);
+            for (const auto& x : other) {
+                ::new (ptr + len) T(x);
+                ++len;
+            }
+        }
+        return *this;
+    }
+
+    auto operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) -> SmallVector& {
+        if (this != &other) {
+            clear();
+            release();
+            take(std::move(other));
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    template<typename... Args>
+    auto emplace_back(Args&&... args) -> T& {
+        if (len == cap) {
+            grow(cap * 2);
+        }
+        auto p = ::new (ptr + len) T(std::forward<Args>(args)...);
+        ++len;
+        return *p;
+    }
+
+    auto push_back(const T& x) -> void {
+        emplace_back(x);
+    }
+
+    auto push_back(T&& x) -> void {
+        emplace_back(std::move(x));
+    }
+
+    auto reserve(std::size_t n) -> void {
+        if (n > cap) {
+            grow(n);
+        }
+    }
+
+    auto clear() -> void {
+        std::destroy(ptr, ptr + len);
+        len = 0;
+    }
+
+    auto size() const -> std::size_t {
+        return len;
+    }
+
+    auto empty() const -> bool {
+        return len == 0;
+    }
+
+    // True once the elements have moved to the heap
+    auto spilled() const -> bool {
+        return ptr != inline_data();
+    }
+
+    auto operator[](std::size_t i) -> T& {
+        return ptr[i];
+    }
+
+    auto operator[](std::size_t i) const -> const T& {
+        return ptr[i];
+    }
+
+    auto begin() -> T* { return ptr; }
+    auto end() -> T* { return ptr + len; }
+    auto begin() const -> const T* { return ptr; }
+    auto end() const -> const T* { return ptr + len; }
+
+private:
+    auto inline_data() const -> T* {
+        return std::launder(reinterpret_cast<T*>(const_cast<std::byte*>(storage)));
+    }
+
+    [[gnu::noinline]] auto grow(std::size_t n) -> void {
+        auto p = static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t { alignof(T) }));
+        std::uninitialized_move(ptr, ptr + len, p);
+        std::destroy(ptr, ptr + len);
+        release();
+        ptr = p;
+        cap = n;
+    }
+
+    auto release() -> void {
+        if (spilled()) {
+            ::operator delete(ptr, std::align_val_t { alignof(T) });
+        }
+        ptr = inline_data();
+        cap = N;
+    }
+
+    // Expects this to be empty and inline
+    auto take(SmallVector&& other) -> void {
+        if (other.spilled()) {
+            ptr = std::exchange(other.ptr, other.inline_data());
+            cap = std::exchange(other.cap, N);
+            len = std::exchange(other.len, 0);
+        } else {
+            std::uninitialized_move(other.begin(), other.end(), ptr);
+            len = other.len;
+            other.clear();
+        }
+    }
+
+    T* ptr = inline_data();
+    std::size_t len = 0;
+    std::size_t cap = N;
+    alignas(T) std::byte storage[N * sizeof(T)];
+};
@@ -0,0 +1,189 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "result.hpp"
+
+// Adapter from C functions that signal failure through a sentinel return
+// value to Result<T, sys::Errno>. The failure convention is a type:
+//
+//   sys::MinusOne  -1 and errno        open, read, write, close, ...
+//   sys::Negative  -errno returned     io_uring, kernel-style APIs
+//   sys::Null      NULL and errno      fopen, opendir, ...
+//   sys::MapFailed MAP_FAILED and errno mmap
+//   sys::NonZero   error number returned, 0 on success: pthread_*, posix_fadvise
+//
+//   auto n = sys::check<sys::MinusOne>(::recv, fd, buf, len, 0); // Result<ssize_t, sys::Errno>
+//
+// check() compiles to the same code as the hand-written `if (r == -1)`;
+// codegen/snippets.cpp pins that. The wrappers do not retry on EINTR.
+
+namespace sys {
+
+struct Errno {
+    int value;
+
+    auto operator==(const Errno&) const -> bool = default;
+};
+
+struct MinusOne {
+    template<typename R>
+    static auto failed(R r) -> bool {
+        return r == static_cast<R>(-1);
+    }
+
+    template<typename R>
+    static auto error(R) -> int {
+        return errno;
+    }
+};
+
+struct Negative {
+    template<typename R>
+    static auto failed(R r) -> bool {
+        return r < 0;
+    }
+
+    template<typename R>
+    static auto error(R r) -> int {
+        return -static_cast<int>(r);
+    }
+};
+
+struct Null {
+    template<typename R>
+    static auto failed(R r) -> bool {
+        return r == nullptr;
+    }
+
+    template<typename R>
+    static auto error(R) -> int {
+        return errno;
+    }
+};
+
+struct MapFailed {
+    static auto failed(void* r) -> bool {
+        return r == MAP_FAILED;
+    }
+
+    static auto error(void*) -> int {
+        return errno;
+    }
+};
+
+struct NonZero {
+    template<typename R>
+    static auto failed(R r) -> bool {
+        return r != 0;
+    }
+
+    template<typename R>
+    static auto error(R r) -> int {
+        return static_cast<int>(r);
+    }
+};
+
+namespace detail {
+
+struct Deduce {};
+
+template<typename Convention, typename R>
+using CheckedValue = std::conditional_t<std::is_same_v<Convention, NonZero>, void, R>;
+
+} // namespace detail
+
+// Calls f(args...) and turns a failure under Convention into Err(Errno).
+// T is the Ok type: the return type by default, void for NonZero, and void
+// may be requested explicitly to drop a meaningless success value.
+template<typename Convention, typename T = detail::Deduce, typename F, typename... Args>
+auto check(F&& f, Args&&... args) {
+    using R = std::invoke_result_t<F, Args...>;
+    using Value = std::conditional_t<std::is_same_v<T, detail::Deduce>, detail::CheckedValue<Convention, R>, T>;
+    auto r = std::forward<F>(f)(std::forward<Args>(args)...);
+    if (Convention::failed(r)) [[unlikely]] {
+        return err<Value, Errno>(Errno { Convention::error(r) });
+    }
+    if constexpr (std::is_void_v<Value>) {
+        return ok<Errno>();
+    } else {
+        return ok<Value, Errno>(static_cast<Value>(r));
+    }
+}
+
+inline auto open(const char* path, int flags, mode_t mode = 0) -> Result<int, Errno> {
+    return check<MinusOne>(::open, path, flags, mode);
+}
+
+inline auto close(int fd) -> Result<void, Errno> {
+    return check<MinusOne, void>(::close, fd);
+}
+
+inline auto read(int fd, void* buf, std::size_t n) -> Result<ssize_t, Errno> {
+    return check<MinusOne>(::read, fd, buf, n);
+}
+
+inline auto write(int fd, const void* buf, std::size_t n) -> Result<ssize_t, Errno> {
+    return check<MinusOne>(::write, fd, buf, n);
+}
+
+inline auto pread(int fd, void* buf, std::size_t n, off_t offset) -> Result<ssize_t, Errno> {
+    return check<MinusOne>(::pread, fd, buf, n, offset);
+}
+
+inline auto pwrite(int fd, const void* buf, std::size_t n, off_t offset) -> Result<ssize_t, Errno> {
+    return check<MinusOne>(::pwrite, fd, buf, n, offset);
+}
+
+inline auto lseek(int fd, off_t offset, int whence) -> Result<off_t, Errno> {
+    return check<MinusOne>(::lseek, fd, offset, whence);
+}
+
+inline auto fstat(int fd) -> Result<struct stat, Errno> {
+    struct stat st;
+    if (::fstat(fd, &st) == -1) {
+        return err<struct stat, Errno>(Errno { errno });
+    }
+    return ok<struct stat, Errno>(st);
+}
+
+inline auto fsync(int fd) -> Result<void, Errno> {
+    return check<MinusOne, void>(::fsync, fd);
+}
+
+inline auto unlink(const char* path) -> Result<void, Errno> {
+    return check<MinusOne, void>(::unlink, path);
+}
+
+inline auto mmap(void* addr, std::size_t length, int prot, int flags, int fd, off_t offset) -> Result<void*, Errno> {
+    return check<MapFailed>(::mmap, addr, length, prot, flags, fd, offset);
+}
+
+inline auto munmap(void* addr, std::size_t length) -> Result<void, Errno> {
+    return check<MinusOne, void>(::munmap, addr, length);
+}
+
+inline auto fopen(const char* path, const char* mode) -> Result<std::FILE*, Errno> {
+    // Standard library functions are not addressable, unlike the POSIX ones
+    return check<Null>([](const char* p, const char* m) { return std::fopen(p, m); }, path, mode);
+}
+
+inline auto posix_fadvise(int fd, off_t offset, off_t length, int advice) -> Result<void, Errno> {
+    return check<NonZero>(::posix_fadvise, fd, offset, length, advice);
+}
+
+} // namespace sys
+
+template<>
+struct Display<sys::Errno> {
+    static void print(sys::Errno e) {
+        std::fprintf(stderr, "%s (errno %d)\n", std::strerror(e.value), e.value);
+    }
+};
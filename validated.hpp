@@ -0,0 +1,226 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "result.hpp"
+#include "small_vector.hpp"
+
+// Accumulating counterpart of Result for batch validation. and_then stops at
+// the first error; Validated keeps going and collects the errors of every
+// independent check, so a form with three bad fields reports all three.
+// Errors live in a SmallVector that only allocates past N of them.
+//
+//   auto v = check(n, validate_positive, validate_even); // Validated<int, ParseError>
+//   auto form = combine(make_form, parse_name(a), parse_age(b));
+
+namespace detail {
+
+struct Unit {};
+
+} // namespace detail
+
+template<typename T, typename E, std::size_t N = 4>
+class Validated {
+    using Value = std::conditional_t<std::is_void_v<T>, detail::Unit, T>;
+
+public:
+    using value_type = T;
+    using error_type = E;
+    using Errors = SmallVector<E, N>;
+
+    Validated(detail::InPlaceOk, Value v) : valid_(true), value_(std::move(v)) {}
+
+    Validated(detail::InPlaceErr, E e) {
+        errors_.push_back(std::move(e));
+    }
+
+    Validated(detail::InPlaceErr, Errors errors) : errors_(std::move(errors)) {}
+
+    Validated(const Result<T, E>& res) : valid_(res.tag == Result<T, E>::Tag::Ok) {
+        if (valid_) {
+            if constexpr (std::is_void_v<T>) {
+                std::construct_at(&value_);
+            } else {
+                std::construct_at(&value_, res.value);
+            }
+        } else {
+            errors_.push_back(res.error);
+        }
+    }
+
+    Validated(const Validated& other) : errors_(other.errors_), valid_(other.valid_) {
+        if (valid_) {
+            std::construct_at(&value_, other.value_);
+        }
+    }
+
+    Validated(Validated&& other) noexcept(std::is_nothrow_move_constructible_v<Value> && std::is_nothrow_move_constructible_v<E>)
+        : errors_(std::move(other.errors_)), valid_(other.valid_) {
+        if (valid_) {
+            std::construct_at(&value_, std::move(other.value_));
+        }
+    }
+
+    auto operator=(Validated other) -> Validated& {
+        destroy_value();
+        errors_ = std::move(other.errors_);
+        valid_ = other.valid_;
+        if (valid_) {
+            std::construct_at(&value_, std::move(other.value_));
+        }
+        return *this;
+    }
+
+    ~Validated() {
+        destroy_value();
+    }
+
+    auto is_valid() const -> bool {
+        return valid_;
+    }
+
+    auto value() const& -> const Value& requires (!std::is_void_v<T>) {
+        return value_;
+    }
+
+    auto value() && -> Value requires (!std::is_void_v<T>) {
+        return std::move(value_);
+    }
+
+    auto errors() const -> const Errors& {
+        return errors_;
+    }
+
+    // Record another error; a valid Validated drops its value.
+    auto add_error(E e) -> void {
+        destroy_value();
+        errors_.push_back(std::move(e));
+    }
+
+    // Append the errors of an independent check
+    template<typename U>
+    auto merge(const Validated<U, E, N>& other) -> void {
+        if (!other.is_valid()) {
+            destroy_value();
+            for (const auto& e : other.errors()) {
+                errors_.push_back(e);
+            }
+        }
+    }
+
+    template<typename F>
+    auto map(F&& f) const -> Validated<std::invoke_result_t<F, const Value&>, E, N> requires (!std::is_void_v<T>) {
+        using U = std::invoke_result_t<F, const Value&>;
+        if (is_valid()) {
+            if constexpr (std::is_void_v<U>) {
+                f(value_);
+                return Validated<void, E, N>(detail::InPlaceOk {}, detail::Unit {});
+            } else {
+                return Validated<U, E, N>(detail::InPlaceOk {}, f(value_));
+            }
+        }
+        return Validated<U, E, N>(detail::InPlaceErr {}, errors_);
+    }
+
+    // Back to a Result carrying the first error
+    auto to_result(detail::SourceLocation loc = detail::SourceLocation::current()) const -> Result<T, E> {
+        if (!is_valid()) {
+            return err<T, E>(errors_[0], loc);
+        }
+        if constexpr (std::is_void_v<T>) {
+            return ok<E>();
+        } else {
+            return ok<T, E>(value_);
+        }
+    }
+
+    // Back to a Result carrying every error
+    auto into_result(detail::SourceLocation loc = detail::SourceLocation::current()) && -> Result<T, Errors> {
+        if (!is_valid()) {
+            return err<T, Errors>(std::move(errors_), loc);
+        }
+        if constexpr (std::is_void_v<T>) {
+            return ok<Errors>();
+        } else {
+            return ok<T, Errors>(std::move(value_));
+        }
+    }
+
+private:
+    auto destroy_value() -> void {
+        if (valid_) {
+            std::destroy_at(&value_);
+            valid_ = false;
+        }
+    }
+
+    Errors errors_;
+    bool valid_ = false;
+    union {
+        Value value_;
+    };
+};
+
+template<typename E, std::size_t N>
+struct Display<SmallVector<E, N>> {
+    static void print(const SmallVector<E, N>& errors) {
+        std::fprintf(stderr, "%zu error(s):\n", errors.size());
+        for (const auto& e : errors) {
+            Display<E>::print(e);
+        }
+    }
+};
+
+template<typename T, typename E, std::size_t N = 4>
+auto valid(T val) -> Validated<T, E, N> {
+    return Validated<T, E, N>(detail::InPlaceOk {}, std::move(val));
+}
+
+template<typename E, std::size_t N = 4>
+auto valid() -> Validated<void, E, N> {
+    return Validated<void, E, N>(detail::InPlaceOk {}, detail::Unit {});
+}
+
+template<typename T, typename E, std::size_t N = 4>
+auto invalid(E e) -> Validated<T, E, N> {
+    return Validated<T, E, N>(detail::InPlaceErr {}, std::move(e));
+}
+
+// Run every check against `val` and keep it only if all of them pass. A
+// check returns Result<void, E> or Validated<void, E, N>; all of them run
+// even after one has failed.
+template<std::size_t N = 4, typename T, typename Check, typename... Checks>
+auto check(T val, Check&& first, Checks&&... rest) {
+    using E = typename std::invoke_result_t<Check, const T&>::error_type;
+    auto status = Validated<void, E, N>(first(std::as_const(val)));
+    (status.merge(Validated<void, E, N>(rest(std::as_const(val)))), ...);
+    if (status.is_valid()) {
+        return valid<T, E, N>(std::move(val));
+    }
+    return Validated<T, E, N>(detail::InPlaceErr {}, status.errors());
+}
+
+// Apply f to the values if every input is valid; otherwise collect the
+// errors of all inputs in argument order.
+template<typename F, typename E, std::size_t N, typename... Ts>
+auto combine(F&& f, const Validated<Ts, E, N>&... vs) -> Validated<std::invoke_result_t<F, const Ts&...>, E, N> {
+    using U = std::invoke_result_t<F, const Ts&...>;
+    if ((vs.is_valid() && ...)) {
+        if constexpr (std::is_void_v<U>) {
+            f(vs.value()...);
+            return valid<E, N>();
+        } else {
+            return valid<U, E, N>(f(vs.value()...));
+        }
+    }
+    typename Validated<U, E, N>::Errors errors;
+    ([&] {
+        for (const auto& e : vs.errors()) {
+            errors.push_back(e);
+        }
+    }(), ...);
+    return Validated<U, E, N>(detail::InPlaceErr {}, std::move(errors));
+}